@@ -0,0 +1,321 @@
+/**
+ * @file monopod_sdk_benchmarks.cpp
+ * @brief Micro benchmarks of the hot paths of a control tick: the Q24
+ * conversions, the decoding of the board frames, the Monopod getters and
+ * setters, the limit checks and the trajectory interpolation.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "monopod_sdk/monopod.hpp"
+#include "monopod_sdk/monopod_drivers/devices/boards.hpp"
+#include "monopod_sdk/monopod_drivers/devices/simulated_boards.hpp"
+#include "monopod_sdk/monopod_drivers/encoder_joint_module.hpp"
+#include "monopod_sdk/monopod_drivers/utils/polynome.hpp"
+
+using namespace monopod_drivers;
+
+/**
+ * @brief SyntheticCanBus feeds the CanBusControlBoards with frames pushed by
+ * the benchmark instead of frames received from a CAN network. The frames sent
+ * by the boards are dropped.
+ */
+class SyntheticCanBus : public CanBusInterface {
+public:
+  SyntheticCanBus(const size_t &history_length)
+      : input_(std::make_shared<CanframeTimeseries>(history_length, 0, false)),
+        sent_input_(
+            std::make_shared<CanframeTimeseries>(history_length, 0, false)),
+        output_(
+            std::make_shared<CanframeTimeseries>(history_length, 0, false)) {}
+
+  std::shared_ptr<const CanframeTimeseries> get_output_frame() const {
+    return output_;
+  }
+
+  std::shared_ptr<const CanframeTimeseries> get_input_frame() {
+    return input_;
+  }
+
+  std::shared_ptr<const CanframeTimeseries> get_sent_input_frame() {
+    return sent_input_;
+  }
+
+  CanBusStats get_stats() const { return CanBusStats(); }
+
+  void set_input_frame(const CanBusFrame &input_frame) {
+    input_->append(input_frame);
+  }
+
+  void set_receive_filter(const std::vector<can_id_t> & /*can_ids*/) {}
+
+  void set_transmit_coalescing(const std::vector<can_id_t> & /*can_ids*/) {}
+
+  void send_if_input_changed() {
+    if (input_->has_changed_since_tag()) {
+      input_->tag(input_->newest_timeindex());
+    }
+  }
+
+  /**
+   * @brief Hand a frame to the boards as if it was received.
+   *
+   * @param frame
+   */
+  void receive(const CanBusFrame &frame) { output_->append(frame); }
+
+private:
+  Ptr<CanframeTimeseries> input_;
+  Ptr<CanframeTimeseries> sent_input_;
+  Ptr<CanframeTimeseries> output_;
+};
+
+/**
+ * @brief Build a frame carrying two Q24 values, as sent by the blmc cards.
+ */
+static CanBusFrame make_q24_pair_frame(const can_id_t &id, const float &first,
+                                       const float &second) {
+  CanBusFrame frame;
+  encode_q24_pair(first, second, frame.data.data());
+  frame.dlc = 8;
+  frame.id = id;
+  return frame;
+}
+
+//------------------------------------------------------------------------------
+// Q24 conversions
+//------------------------------------------------------------------------------
+
+static void BM_FloatToQ24(benchmark::State &state) {
+  float value = 0.123f;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(float_to_q24(value));
+    value += 1e-6f;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FloatToQ24);
+
+static void BM_DecodeQ24Pair(benchmark::State &state) {
+  CanBusFrame frame = make_q24_pair_frame(0x30, 0.123f, -0.456f);
+  float first, second;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(frame.data);
+    decode_q24_pair(frame.data.data(), first, second);
+    benchmark::DoNotOptimize(first);
+    benchmark::DoNotOptimize(second);
+  }
+  state.SetItemsProcessed(2 * state.iterations());
+}
+BENCHMARK(BM_DecodeQ24Pair);
+
+/**
+ * @brief Decode the payloads of a recorded log in one go.
+ */
+static void BM_DecodeQ24Pairs(benchmark::State &state) {
+  const size_t count = state.range(0);
+  std::vector<CanBusFrame> frames(count);
+  for (size_t i = 0; i < count; i++) {
+    frames[i] = make_q24_pair_frame(0x30, 1e-3f * i, -1e-3f * i);
+  }
+  std::vector<float> first(count), second(count);
+  for (auto _ : state) {
+    decode_q24_pairs(frames.data(), count, first.data(), second.data());
+    benchmark::DoNotOptimize(first.data());
+    benchmark::DoNotOptimize(second.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(2 * state.iterations() * count);
+}
+BENCHMARK(BM_DecodeQ24Pairs)->Arg(64)->Arg(4096);
+
+static void BM_EncodeQ24Pairs(benchmark::State &state) {
+  const size_t count = state.range(0);
+  std::vector<float> first(count), second(count);
+  for (size_t i = 0; i < count; i++) {
+    first[i] = 1e-3f * i;
+    second[i] = -1e-3f * i;
+  }
+  std::vector<CanBusFrame> frames(count);
+  for (auto _ : state) {
+    encode_q24_pairs(first.data(), second.data(), count, frames.data());
+    benchmark::DoNotOptimize(frames.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(2 * state.iterations() * count);
+}
+BENCHMARK(BM_EncodeQ24Pairs)->Arg(64)->Arg(4096);
+
+//------------------------------------------------------------------------------
+// Frame decoding
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Decode batches of the frames streamed by the motor board, from their
+ * reception to their publication in the snapshot.
+ */
+static void BM_DecodeFrames(benchmark::State &state) {
+  const size_t batch_size = state.range(0);
+  auto can_bus = std::make_shared<SyntheticCanBus>(4 * batch_size);
+  HistoryConfig history;
+  history.frame_length = 4 * batch_size;
+  CanBusControlBoards boards({can_bus}, {0, 0, 0}, {}, history);
+
+  // position, velocity, acceleration and current of the motor board.
+  const std::vector<CanBusFrame> frames = {
+      make_q24_pair_frame(0x30, 0.1f, 0.2f),
+      make_q24_pair_frame(0x40, 1.0f, 2.0f),
+      make_q24_pair_frame(0x70, 10.0f, 20.0f),
+      make_q24_pair_frame(0x20, 0.5f, 0.6f)};
+
+  BoardsSnapshot snapshot;
+  boards.get_snapshot(snapshot);
+  uint64_t frame_count = snapshot.frame_count;
+  for (auto _ : state) {
+    for (size_t i = 0; i < batch_size; i++) {
+      can_bus->receive(frames[i % frames.size()]);
+    }
+    frame_count += batch_size;
+    do {
+      boards.get_snapshot(snapshot);
+    } while (snapshot.frame_count < frame_count);
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_DecodeFrames)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+//------------------------------------------------------------------------------
+// Monopod round trips on the simulated boards
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Monopod running on the simulated boards in lockstep, such that the
+ * measurements only change when the benchmark sends controls.
+ */
+static Monopod &get_simulated_monopod() {
+  static Monopod monopod;
+  if (!monopod.initialized()) {
+    MonopodConfig config;
+    config.simulation.real_time = false;
+    monopod.initialize(Mode::FREE, true, config);
+  }
+  return monopod;
+}
+
+static void BM_GetPositions(benchmark::State &state) {
+  Monopod &monopod = get_simulated_monopod();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(monopod.get_positions());
+  }
+}
+BENCHMARK(BM_GetPositions);
+
+static void BM_GetPositionsInto(benchmark::State &state) {
+  Monopod &monopod = get_simulated_monopod();
+  Eigen::VectorXd positions(NUMBER_JOINTS);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(monopod.get_positions(positions));
+  }
+}
+BENCHMARK(BM_GetPositionsInto);
+
+static void BM_ReadState(benchmark::State &state) {
+  Monopod &monopod = get_simulated_monopod();
+  StateSnapshot snapshot;
+  for (auto _ : state) {
+    monopod.read_state(snapshot);
+    benchmark::DoNotOptimize(snapshot);
+  }
+}
+BENCHMARK(BM_ReadState);
+
+static void BM_SetTorqueTargets(benchmark::State &state) {
+  Monopod &monopod = get_simulated_monopod();
+  const Vector<double> torques = {0.0, 0.0};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(monopod.set_torque_targets(torques));
+  }
+}
+BENCHMARK(BM_SetTorqueTargets);
+
+static void BM_SetTorqueTargetsFrom(benchmark::State &state) {
+  Monopod &monopod = get_simulated_monopod();
+  const Eigen::VectorXd torques = Eigen::VectorXd::Zero(NUMBER_LEG_JOINTS);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(monopod.set_torque_targets(torques));
+  }
+}
+BENCHMARK(BM_SetTorqueTargetsFrom);
+
+/**
+ * @brief A full control tick: read the state and send new torques, which
+ * steps the simulation once.
+ */
+static void BM_ControlTick(benchmark::State &state) {
+  Monopod &monopod = get_simulated_monopod();
+  StateSnapshot snapshot;
+  Vector<double> torques = {0.0, 0.0};
+  for (auto _ : state) {
+    monopod.read_state(snapshot);
+    torques[0] = -0.01 * snapshot.position[hip_joint];
+    torques[1] = -0.01 * snapshot.position[knee_joint];
+    benchmark::DoNotOptimize(monopod.set_torque_targets(torques));
+  }
+}
+BENCHMARK(BM_ControlTick);
+
+//------------------------------------------------------------------------------
+// Limits
+//------------------------------------------------------------------------------
+
+static void BM_CheckLimits(benchmark::State &state) {
+  SimulationParameters parameters;
+  parameters.real_time = false;
+  auto boards = std::make_shared<SimulatedControlBoards>(parameters);
+  auto encoder = std::make_shared<Encoder>(boards, planarizer_pitch_joint);
+  EncoderJointModule joint(planarizer_pitch_joint, encoder, 1.0, 0.0);
+  joint.set_limit(position, JointLimit(-M_PI, M_PI));
+  joint.set_limit(velocity, JointLimit(-10.0, 10.0));
+  joint.set_limit(acceleration, JointLimit(-100.0, 100.0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(joint.check_limits());
+  }
+}
+BENCHMARK(BM_CheckLimits);
+
+//------------------------------------------------------------------------------
+// Trajectories
+//------------------------------------------------------------------------------
+
+static void BM_TimePolynomeCompute(benchmark::State &state) {
+  TimePolynome<5> polynome;
+  polynome.set_parameters(1.0, 0.0, 0.0, 1.0);
+  double t = 0.0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(polynome.compute(t));
+    benchmark::DoNotOptimize(polynome.compute_derivative(t));
+    t = t < 1.0 ? t + 1e-3 : 0.0;
+  }
+}
+BENCHMARK(BM_TimePolynomeCompute);
+
+static void BM_TimePolynomeComputeBatch(benchmark::State &state) {
+  TimePolynome<5> polynome;
+  polynome.set_parameters(1.0, 0.0, 0.0, 1.0);
+  const Eigen::ArrayXd t = Eigen::ArrayXd::LinSpaced(state.range(0), 0.0, 1.0);
+  Eigen::ArrayXd value(t.size()), derivative(t.size()),
+      sec_derivative(t.size());
+  for (auto _ : state) {
+    polynome.compute(t, value, derivative, sec_derivative);
+    benchmark::DoNotOptimize(value.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * t.size());
+}
+BENCHMARK(BM_TimePolynomeComputeBatch)->Arg(64)->Arg(1024);
+
+BENCHMARK_MAIN();
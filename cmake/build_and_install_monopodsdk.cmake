@@ -40,11 +40,19 @@
         include/monopod_sdk/monopod_drivers/utils/polynome.hpp
         include/monopod_sdk/monopod_drivers/utils/polynome.hxx
         include/monopod_sdk/monopod_drivers/utils/os_interface.hpp
+        include/monopod_sdk/monopod_drivers/utils/q24_codec.hpp
+        include/monopod_sdk/monopod_drivers/utils/seqlock.hpp
+        include/monopod_sdk/monopod_drivers/utils/ring_buffer.hpp
+        include/monopod_sdk/monopod_drivers/utils/stats.hpp
+        include/monopod_sdk/monopod_drivers/utils/thread_policy.hpp
+        include/monopod_sdk/monopod_drivers/utils/worker_pool.hpp
         )
 
     add_library(utils
                 ${MONOPOD_UTILS_PUBLIC_HDRS}
-                 src/utils/polynome.cpp)
+                 src/utils/polynome.cpp
+                 src/utils/thread_policy.cpp
+                 src/utils/worker_pool.cpp)
 
     add_library(MonopodSdk::utils ALIAS utils)
 
@@ -56,7 +64,9 @@
 
     target_link_libraries(utils
         PUBLIC
-        real_time_tools::real_time_tools)
+        real_time_tools::real_time_tools
+        Eigen3::Eigen
+        Threads::Threads)
     # If on xenomai we need to link to the real time os librairies.
 
     if(Xenomai_FOUND)
@@ -75,8 +85,11 @@
         include/monopod_sdk/monopod_drivers/devices/boards.hpp
         # Changed stuff
         include/monopod_sdk/monopod_drivers/devices/can_bus.hpp
+        include/monopod_sdk/monopod_drivers/devices/can_bus_replay.hpp
         include/monopod_sdk/monopod_drivers/devices/motor.hpp
         include/monopod_sdk/monopod_drivers/devices/encoder.hpp
+        include/monopod_sdk/monopod_drivers/devices/telemetry_recorder.hpp
+        include/monopod_sdk/monopod_drivers/devices/simulated_boards.hpp
         )
 
     add_library(devices
@@ -84,8 +97,11 @@
       src/boards.cpp
       # Changed stuff
       src/can_bus.cpp
+      src/can_bus_replay.cpp
       src/motor.cpp
       src/encoder.cpp
+      src/telemetry_recorder.cpp
+      src/simulated_boards.cpp
     )
 
     add_library(MonopodSdk::devices ALIAS devices)
@@ -176,13 +192,17 @@
 
   set(MONOPOD_SDK_CORE_PUBLIC_HDRS
     include/monopod_sdk/monopod.hpp
+    include/monopod_sdk/monopod_array.hpp
     include/monopod_sdk/common_header.hpp
     include/monopod_sdk/mode.hpp
+    include/monopod_sdk/shared_memory_bridge.hpp
   )
 
   add_library(MonopodSdk
     ${MONOPOD_SDK_CORE_PUBLIC_HDRS}
     src/monopod.cpp
+    src/monopod_array.cpp
+    src/shared_memory_bridge.cpp
   )
 
   add_library(MonopodSdk::MonopodSdk ALIAS MonopodSdk)
@@ -240,6 +260,23 @@
 
     add_demo(demo_leg_sine_position)
     add_demo(demo_print_sdk)
+    add_demo(demo_hil_benchmark)
+
+# ===============================
+# Benchmarks
+# ===============================
+
+    if(MONOPODSDK_BUILD_BENCHMARKS)
+      add_executable(MonopodSdkBenchmarks
+        benchmarks/monopod_sdk_benchmarks.cpp)
+      target_link_libraries(MonopodSdkBenchmarks
+        MonopodDrivers
+        MonopodSdk
+        utils
+        devices
+        benchmark::benchmark
+      )
+    endif()
 
 # ===============================
 # Install
@@ -0,0 +1,452 @@
+#include <math.h>
+#include <signal.h>
+#include <sys/utsname.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "monopod_sdk/monopod.hpp"
+#include "monopod_sdk/monopod_drivers/utils/stats.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
+
+using namespace monopod_drivers;
+
+/**
+ * @brief This boolean is here to kill cleanly the application upon ctrl+c
+ */
+std::atomic_bool StopDemos(false);
+
+/**
+ * @brief This function is the callback upon a ctrl+c call from the terminal.
+ *
+ * @param s
+ */
+void my_handler(int) { StopDemos = true; }
+
+/**
+ * @brief Options of the benchmark, see print_usage.
+ */
+struct BenchmarkOptions {
+  std::string backend = "sim";
+  std::string replay_log;
+  double replay_speed = 1.0;
+  Mode mode = Mode::MOTOR_BOARD;
+  Vector<std::string> profiles = {"torque", "position", "hold"};
+  double rate_hz = 1000.0;
+  double duration_s = 5.0;
+  std::string format = "json";
+  std::string output;
+  ThreadPolicy thread = ThreadPolicy();
+};
+
+/**
+ * @brief Results of one profile. The latencies of the sdk come from a fresh
+ * Monopod, hence only cover this profile.
+ */
+struct ProfileReport {
+  std::string profile;
+  uint64_t ticks = 0;
+  //! Ticks which started more than half a period late.
+  uint64_t late_ticks = 0;
+  //! Time between two ticks of the control loop.
+  LatencySummary interval;
+  //! Distance between the interval and the nominal period.
+  LatencySummary jitter;
+  //! Time from a command to the first newer snapshot read by the loop, the
+  //! resolution is one period.
+  LatencySummary command_to_measurement;
+  //! Frames on all the buses and upper bound of the busiest bus load.
+  uint64_t can_frames = 0;
+  double can_utilization = 0.0;
+  uint64_t dropped_frames = 0;
+  uint64_t send_retries = 0;
+  uint64_t coalesced_frames = 0;
+  uint64_t rejected_frames = 0;
+  MonopodStats stats;
+};
+
+/**
+ * @brief The control loop of a profile, run by a real-time thread.
+ */
+struct ProfileRun {
+  Monopod *monopod;
+  const BenchmarkOptions *options;
+  ProfileReport *report;
+};
+
+static void print_usage(const char *name) {
+  std::cerr
+      << "usage: " << name << " [options]\n"
+      << "  --backend sim|robot|replay\n"
+      << "                          simulated boards (default), the robot or\n"
+      << "                          a recorded CAN log\n"
+      << "  --log FILE              CAN log of the replay backend\n"
+      << "  --replay-speed X        playback speed of the log (default 1)\n"
+      << "  --mode free|fixed_connector|fixed|motor_board\n"
+      << "  --profiles torque,position,hold\n"
+      << "  --rate HZ               control rate, 1000 to 4000 (default 1000)\n"
+      << "  --duration S            duration of each profile (default 5)\n"
+      << "  --cpu N --priority P    scheduling of the control loop\n"
+      << "  --format json|csv       (default json)\n"
+      << "  --output FILE           (default stdout)\n";
+}
+
+/**
+ * @brief Parse the command line.
+ *
+ * @return bool false if the arguments are invalid.
+ */
+static bool parse_options(int argc, char **argv, BenchmarkOptions &options) {
+  for (int i = 1; i < argc; i++) {
+    const std::string option = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const std::string value = argv[++i];
+    if (option == "--backend") {
+      if (value != "sim" && value != "robot" && value != "replay") {
+        return false;
+      }
+      options.backend = value;
+    } else if (option == "--log") {
+      options.replay_log = value;
+    } else if (option == "--replay-speed") {
+      options.replay_speed = std::atof(value.c_str());
+    } else if (option == "--mode") {
+      if (value == "free") {
+        options.mode = Mode::FREE;
+      } else if (value == "fixed_connector") {
+        options.mode = Mode::FIXED_CONNECTOR;
+      } else if (value == "fixed") {
+        options.mode = Mode::FIXED;
+      } else if (value == "motor_board") {
+        options.mode = Mode::MOTOR_BOARD;
+      } else {
+        return false;
+      }
+    } else if (option == "--profiles") {
+      options.profiles.clear();
+      std::istringstream names(value);
+      std::string name;
+      while (std::getline(names, name, ',')) {
+        if (name != "torque" && name != "position" && name != "hold") {
+          return false;
+        }
+        options.profiles.push_back(name);
+      }
+    } else if (option == "--rate") {
+      options.rate_hz = std::atof(value.c_str());
+    } else if (option == "--duration") {
+      options.duration_s = std::atof(value.c_str());
+    } else if (option == "--cpu") {
+      options.thread.cpu = std::atoi(value.c_str());
+    } else if (option == "--priority") {
+      options.thread.priority = std::atoi(value.c_str());
+    } else if (option == "--format") {
+      if (value != "json" && value != "csv") {
+        return false;
+      }
+      options.format = value;
+    } else if (option == "--output") {
+      options.output = value;
+    } else {
+      return false;
+    }
+  }
+  return options.rate_hz >= 1000.0 && options.rate_hz <= 4000.0 &&
+         options.duration_s > 0.0 && !options.profiles.empty() &&
+         (options.backend != "replay" || !options.replay_log.empty()) &&
+         options.replay_speed >= 0.0;
+}
+
+/**
+ * @brief Drive the leg through the profile of the report and time the loop.
+ */
+static THREAD_FUNCTION_RETURN_TYPE profile_loop(void *instance_pointer) {
+  ProfileRun &run = *static_cast<ProfileRun *>(instance_pointer);
+  Monopod &monopod = *run.monopod;
+  ProfileReport &report = *run.report;
+  const double period_s = 1.0 / run.options->rate_hz;
+  const uint64_t period_ns = period_s * 1e9;
+  const uint64_t tick_count = run.options->duration_s * run.options->rate_hz;
+  const bool is_commanding = report.profile != "hold";
+
+  if (!is_commanding) {
+    monopod.hold_position(period_s);
+  }
+
+  LatencyHistogram interval, jitter, command_to_measurement;
+  StateSnapshot state;
+  Vector<double> torques = {0.0, 0.0};
+  std::array<double, NUMBER_LEG_JOINTS> initial_position = {0.0, 0.0};
+  uint64_t last_tick_ns = 0;
+  uint64_t command_ns = 0;
+  uint64_t command_frame_count = 0;
+
+  real_time_tools::Spinner spinner;
+  spinner.set_period(period_s);
+  for (uint64_t tick = 0; tick < tick_count && !StopDemos; tick++) {
+    spinner.spin();
+    const uint64_t now_ns = get_wall_time_ns();
+    if (last_tick_ns != 0) {
+      const uint64_t elapsed_ns = now_ns - last_tick_ns;
+      interval.record(elapsed_ns);
+      jitter.record(elapsed_ns > period_ns ? elapsed_ns - period_ns
+                                           : period_ns - elapsed_ns);
+      report.late_ticks += elapsed_ns > period_ns + period_ns / 2;
+    }
+    last_tick_ns = now_ns;
+
+    monopod.read_state(state);
+    if (tick == 0) {
+      initial_position = {state.position[hip_joint],
+                          state.position[knee_joint]};
+    }
+    if (command_ns != 0 && state.frame_count != command_frame_count) {
+      command_to_measurement.record(now_ns - command_ns);
+      command_ns = 0;
+    }
+    report.ticks++;
+    if (!is_commanding) {
+      continue;
+    }
+
+    // Small motions around the pose of the first tick, the leg must be free
+    // to move. No calibration is needed as the reference is relative.
+    const double t = tick * period_s;
+    if (report.profile == "torque") {
+      torques[0] = 0.05 * sin(2 * M_PI * 1.0 * t);
+      torques[1] = 0.05 * sin(2 * M_PI * 1.0 * t + M_PI / 2);
+    } else {
+      const double offset = 0.2 * sin(2 * M_PI * 0.5 * t);
+      for (int j = 0; j < NUMBER_LEG_JOINTS; j++) {
+        torques[j] = 2.0 * (initial_position[j] + offset - state.position[j]) -
+                     0.05 * state.velocity[j];
+      }
+    }
+    monopod.set_torque_targets(torques);
+    if (command_ns == 0) {
+      command_ns = get_wall_time_ns();
+      command_frame_count = state.frame_count;
+    }
+  }
+
+  if (!is_commanding) {
+    monopod.stop_hold_position();
+  } else {
+    monopod.set_torque_targets({0.0, 0.0});
+  }
+  report.interval = interval.get_summary();
+  report.jitter = jitter.get_summary();
+  report.command_to_measurement = command_to_measurement.get_summary();
+  return THREAD_FUNCTION_RETURN_VALUE;
+}
+
+/**
+ * @brief Run one profile on a freshly initialized Monopod.
+ */
+static ProfileReport run_profile(const std::string &profile,
+                                 const BenchmarkOptions &options) {
+  ProfileReport report;
+  report.profile = profile;
+
+  MonopodConfig config;
+  if (options.backend == "replay") {
+    config.replay_log = options.replay_log;
+    config.replay_speed = options.replay_speed;
+  }
+  auto monopod = std::make_unique<Monopod>();
+  monopod->initialize(options.mode, options.backend == "sim", config);
+
+  ProfileRun run = {monopod.get(), &options, &report};
+  real_time_tools::RealTimeThread thread;
+  options.thread.apply(thread);
+  const double start_s = real_time_tools::Timer::get_current_time_sec();
+  thread.create_realtime_thread(&profile_loop, &run);
+  thread.join();
+  const double elapsed_s =
+      real_time_tools::Timer::get_current_time_sec() - start_s;
+
+  report.stats = monopod->get_stats();
+  // Every frame is counted with an 8 bytes payload and the worst bit
+  // stuffing, see CanBus.
+  const double frame_bits = 34 + 64 + 13 + (34 + 64 - 1) / 4;
+  for (const auto &bus : report.stats.boards.can_buses) {
+    const uint64_t frames = bus.received_frames + bus.sent_frames;
+    report.can_frames += frames;
+    report.can_utilization = std::max(
+        report.can_utilization,
+        frames * frame_bits / (config.can_transmit.bitrate * elapsed_s));
+    report.dropped_frames += bus.dropped_frames;
+    report.send_retries += bus.send_retries;
+    report.coalesced_frames += bus.coalesced_frames;
+    report.rejected_frames += bus.rejected_frames;
+  }
+  return report;
+}
+
+/**
+ * @brief Write a latency summary as a JSON object.
+ */
+static void write_json(std::ostream &out, const LatencySummary &summary) {
+  out << "{\"count\": " << summary.count << ", \"min_ns\": " << summary.min_ns
+      << ", \"mean_ns\": " << summary.mean_ns
+      << ", \"p50_ns\": " << summary.p50_ns
+      << ", \"p90_ns\": " << summary.p90_ns
+      << ", \"p99_ns\": " << summary.p99_ns
+      << ", \"p999_ns\": " << summary.p999_ns
+      << ", \"max_ns\": " << summary.max_ns << "}";
+}
+
+static void write_json(std::ostream &out, const BenchmarkOptions &options,
+                       const struct utsname &host,
+                       const Vector<ProfileReport> &reports) {
+  out << "{\n  \"host\": {\"sysname\": \"" << host.sysname
+      << "\", \"release\": \"" << host.release << "\", \"version\": \""
+      << host.version << "\", \"machine\": \"" << host.machine << "\"},\n";
+#ifdef __XENO__
+  out << "  \"xenomai\": true,\n";
+#else
+  out << "  \"xenomai\": false,\n";
+#endif
+  out << "  \"backend\": \"" << options.backend
+      << "\",\n  \"rate_hz\": " << options.rate_hz
+      << ",\n  \"duration_s\": " << options.duration_s
+      << ",\n  \"profiles\": [";
+  for (size_t i = 0; i < reports.size(); i++) {
+    const ProfileReport &report = reports[i];
+    out << (i == 0 ? "\n" : ",\n") << "    {\"profile\": \"" << report.profile
+        << "\", \"ticks\": " << report.ticks
+        << ", \"late_ticks\": " << report.late_ticks
+        << ",\n     \"interval\": ";
+    write_json(out, report.interval);
+    out << ",\n     \"jitter\": ";
+    write_json(out, report.jitter);
+    out << ",\n     \"command_to_measurement\": ";
+    write_json(out, report.command_to_measurement);
+    out << ",\n     \"read\": ";
+    write_json(out, report.stats.read);
+    out << ",\n     \"decode\": ";
+    write_json(out, report.stats.boards.decode);
+    out << ",\n     \"control\": ";
+    write_json(out, report.stats.boards.control);
+    out << ",\n     \"can\": {\"frames\": " << report.can_frames
+        << ", \"utilization\": " << report.can_utilization
+        << ", \"dropped_frames\": " << report.dropped_frames
+        << ", \"send_retries\": " << report.send_retries
+        << ", \"coalesced_frames\": " << report.coalesced_frames
+        << ", \"rejected_frames\": " << report.rejected_frames << "}"
+        << ",\n     \"threads\": [";
+    for (size_t j = 0; j < report.stats.threads.size(); j++) {
+      const ThreadStats &thread = report.stats.threads[j];
+      out << (j == 0 ? "\n" : ",\n") << "       {\"name\": \"" << thread.name
+          << "\", \"period_ns\": " << thread.period_ns
+          << ", \"iterations\": " << thread.iterations
+          << ", \"missed_deadlines\": " << thread.missed_deadlines
+          << ", \"interval\": ";
+      write_json(out, thread.interval);
+      out << "}";
+    }
+    out << "]}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+/**
+ * @brief Write the columns of a latency summary.
+ */
+static void write_csv(std::ostream &out, const LatencySummary &summary) {
+  out << "," << summary.mean_ns << "," << summary.p50_ns << ","
+      << summary.p99_ns << "," << summary.max_ns;
+}
+
+static void write_csv(std::ostream &out, const BenchmarkOptions &options,
+                      const struct utsname &host,
+                      const Vector<ProfileReport> &reports) {
+  const char *latencies[] = {"interval", "jitter", "command_to_measurement",
+                             "safety_interval"};
+  out << "release,backend,rate_hz,profile,ticks,late_ticks";
+  for (const char *latency : latencies) {
+    out << "," << latency << "_mean_ns," << latency << "_p50_ns," << latency
+        << "_p99_ns," << latency << "_max_ns";
+  }
+  out << ",safety_missed_deadlines,can_frames,can_utilization,"
+         "dropped_frames,send_retries,coalesced_frames,rejected_frames\n";
+
+  for (const ProfileReport &report : reports) {
+    ThreadStats safety;
+    for (const ThreadStats &thread : report.stats.threads) {
+      if (thread.name == "safety_loop") {
+        safety = thread;
+      }
+    }
+    out << host.release << "," << options.backend << "," << options.rate_hz
+        << "," << report.profile << "," << report.ticks << ","
+        << report.late_ticks;
+    write_csv(out, report.interval);
+    write_csv(out, report.jitter);
+    write_csv(out, report.command_to_measurement);
+    write_csv(out, safety.interval);
+    out << "," << safety.missed_deadlines << "," << report.can_frames << ","
+        << report.can_utilization << "," << report.dropped_frames << ","
+        << report.send_retries << "," << report.coalesced_frames << ","
+        << report.rejected_frames << "\n";
+  }
+}
+
+/**
+ * @brief Run the profiles one after the other and write the report.
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main(int argc, char **argv) {
+  // make sure we catch the ctrl+c signal to kill the application properly.
+  struct sigaction sigIntHandler;
+  sigIntHandler.sa_handler = my_handler;
+  sigemptyset(&sigIntHandler.sa_mask);
+  sigIntHandler.sa_flags = 0;
+  sigaction(SIGINT, &sigIntHandler, NULL);
+  StopDemos = false;
+
+  BenchmarkOptions options;
+  if (!parse_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  Vector<ProfileReport> reports;
+  for (const auto &profile : options.profiles) {
+    if (StopDemos) {
+      break;
+    }
+    rt_printf("running the %s profile \n", profile.c_str());
+    reports.push_back(run_profile(profile, options));
+  }
+
+  struct utsname host;
+  uname(&host);
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output);
+    if (!file) {
+      std::cerr << "cannot open " << options.output << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = options.output.empty() ? std::cout : file;
+  if (options.format == "json") {
+    write_json(out, options, host, reports);
+  } else {
+    write_csv(out, options, host, reports);
+  }
+  return 0;
+}
@@ -1,15 +1,10 @@
 #include "sine_position_control.hpp"
 #include "real_time_tools/spinner.hpp"
 #include "real_time_tools/timer.hpp"
-#include <fstream>
 
 namespace monopod_drivers {
 
 void SinePositionControl::loop() {
-  // here is the control in torque (NM)
-  double actual_torque_hip = 0.0;
-  double actual_torque_knee = 0.0;
-
   double actual_position_hip = 0.0;
   double actual_position_knee = 0.0;
 
@@ -38,8 +33,6 @@ void SinePositionControl::loop() {
   kd = 0;
   set_gains(kp, kd);
 
-  real_time_tools::Spinner spinner;
-  spinner.set_period(control_period); // here we spin every 1ms
   real_time_tools::Timer time_logger;
   size_t count = 0;
   while (!stop_loop_) {
@@ -57,10 +50,6 @@ void SinePositionControl::loop() {
     actual_velocity_hip = data[0];
     actual_velocity_knee = data[1];
 
-    data = sdk_->get_torque_targets({hip_joint, knee_joint}).value();
-    actual_torque_hip = data[0];
-    actual_torque_knee = data[1];
-
     double desired_position =
         amplitude * sin(2 * M_PI * frequence * local_time);
     desired_position_hip = desired_position;
@@ -96,18 +85,8 @@ void SinePositionControl::loop() {
     sdk_->set_torque_targets({desired_torque_hip, desired_torque_knee},
                              {hip_joint, knee_joint});
 
-    encoders_[0].push_back(actual_position_hip);
-    velocities_[0].push_back(actual_velocity_hip);
-    torques_[0].push_back(actual_torque_hip);
-    control_buffer_[0].push_back(desired_torque_hip);
-
-    encoders_[1].push_back(actual_position_knee);
-    velocities_[1].push_back(actual_velocity_knee);
-    torques_[1].push_back(actual_torque_knee);
-    control_buffer_[1].push_back(desired_torque_knee);
-
-    // we sleep here 1ms.
-    spinner.spin();
+    // we wait here for the next measurements, the boards send them every 1ms.
+    sdk_->wait_for_new_state(10 * control_period);
     // measure the time spent.
     time_logger.tac();
 
@@ -134,32 +113,19 @@ void SinePositionControl::loop() {
   time_logger.dump_measurements("/tmp/demo_pd_control_time_measurement");
 }
 
-void SinePositionControl::stop_loop() {
-  // dumping stuff
-  std::string file_name = "/tmp/sine_position_xp.dat";
-  try {
-    std::ofstream log_file(file_name, std::ios::binary | std::ios::out);
-    log_file.precision(10);
-
-    assert(encoders_[0].size() == velocities_[0].size() &&
-           velocities_[0].size() == control_buffer_[0].size() &&
-           control_buffer_[0].size() == torques_[0].size());
-    for (size_t j = 0; j < encoders_[0].size(); ++j) {
-      for (size_t i = 0; i < encoders_.size(); ++i) {
-        log_file << encoders_[i][j] << " " << velocities_[i][j] << " "
-                 << control_buffer_[i][j] << " " << torques_[i][j] << " ";
-      }
-      log_file << std::endl;
-    }
-
-    log_file.flush();
-    log_file.close();
-  } catch (...) {
-    rt_printf("fstream Error in dump_tic_tac_measurements(): "
-              "no time measurment saved\n");
+void SinePositionControl::start_loop() {
+  // the measurements and the controls sent are recorded by the sdk.
+  std::string file_name = "/tmp/sine_position_xp.bin";
+  if (!sdk_->start_recording(file_name)) {
+    rt_printf("could not record the trajectory to %s\n", file_name.c_str());
   }
+  rt_thread_.create_realtime_thread(&SinePositionControl::loop, this);
+}
 
-  rt_printf("dumped the trajectory");
+void SinePositionControl::stop_loop() {
+  uint64_t dropped_records = sdk_->stop_recording();
+  rt_printf("dumped the trajectory, %lu records dropped\n",
+            (unsigned long)dropped_records);
 }
 
 } // namespace monopod_drivers
@@ -22,21 +22,6 @@ public:
    */
   SinePositionControl(sdk_Ptr sdk) {
     sdk_ = sdk;
-    encoders_.clear();
-    velocities_.clear();
-    torques_.clear();
-    control_buffer_.clear();
-
-    for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
-      encoders_.push_back(std::deque<double>());
-      torques_.push_back(std::deque<double>());
-      velocities_.push_back(std::deque<double>());
-      control_buffer_.push_back(std::deque<double>());
-      encoders_.back().clear();
-      velocities_.back().clear();
-      torques_.back().clear();
-      control_buffer_.back().clear();
-    }
     stop_loop_ = false;
     kp_ = 0.1;
     kd_ = 0.0;
@@ -51,14 +36,13 @@ public:
   }
 
   /**
-   * @brief This method is a helper to start the thread loop.
+   * @brief This method is a helper to start the thread loop. The traffic of
+   * the boards is recorded while the loop runs.
    */
-  void start_loop() {
-    rt_thread_.create_realtime_thread(&SinePositionControl::loop, this);
-  }
+  void start_loop();
 
   /**
-   * @brief Stop the control and dump the data
+   * @brief Stop the recording of the traffic.
    */
   void stop_loop();
 
@@ -106,26 +90,6 @@ private:
    */
   sdk_Ptr sdk_;
 
-  /**
-   * @brief Encoder data
-   */
-  std::vector<std::deque<double>> encoders_;
-
-  /**
-   * @brief Velocity data
-   */
-  std::vector<std::deque<double>> velocities_;
-
-  /**
-   * @brief torque data
-   */
-  std::vector<std::deque<double>> torques_;
-
-  /**
-   * @brief control_buffer_
-   */
-  std::vector<std::deque<double>> control_buffer_;
-
   /**
    * @brief Controller proportional gain.
    */
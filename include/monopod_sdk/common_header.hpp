@@ -22,6 +22,21 @@ namespace monopod_drivers {
  */
 #define NUMBER_LEG_JOINTS 2
 
+/**
+ * Number of joints in a monopod_drivers::Monopod, see JointNamesIndex.
+ */
+#define NUMBER_JOINTS 5
+
+/**
+ * Torque constant of the leg motors in Nm/A, see MotorJointModule.
+ */
+#define LEG_MOTOR_CONSTANT 0.025
+
+/**
+ * Gear ratio between the leg motors and the leg joints, see MotorJointModule.
+ */
+#define LEG_GEAR_RATIO 9.0
+
 /**
  * ================================================
  * Type defs
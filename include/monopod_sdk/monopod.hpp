@@ -1,22 +1,296 @@
 #pragma once
 
+#include <Eigen/Dense>
 #include <real_time_tools/spinner.hpp>
 #include <real_time_tools/thread.hpp>
 #include <real_time_tools/timer.hpp>
 #include <time_series/time_series.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
+#include <limits>
 #include <math.h>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <tuple>
 #include <unordered_map>
 
 #include "monopod_sdk/common_header.hpp"
+#include "monopod_sdk/monopod_drivers/devices/simulated_boards.hpp"
 #include "monopod_sdk/monopod_drivers/leg.hpp"
+#include "monopod_sdk/monopod_drivers/utils/seqlock.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
 
 namespace monopod_drivers {
 
+/**
+ * @brief RealtimeConfig sets the scheduling of the real-time threads of the
+ * sdk and the memory policy of the process, such that they do not contend
+ * with the control thread of the user. The sending threads of the CAN
+ * interfaces are set by MonopodConfig::can_transmit.
+ */
+struct RealtimeConfig {
+  /**
+   * @brief Receive thread of each CAN interface. The CPU is overridden by
+   * MonopodConfig::receive_cpus for the interfaces listed there.
+   */
+  monopod_drivers::ThreadPolicy can_receive;
+
+  /**
+   * @brief Thread decoding the frames of each CAN interface, the CPU is
+   * overridden like the one of can_receive.
+   */
+  monopod_drivers::ThreadPolicy decode;
+
+  /**
+   * @brief Thread checking the joint limits.
+   */
+  monopod_drivers::ThreadPolicy safety;
+
+  /**
+   * @brief Threads of the leg holding the pose and streaming trajectories.
+   */
+  monopod_drivers::ThreadPolicy leg_hold;
+  monopod_drivers::ThreadPolicy leg_trajectory;
+
+  /**
+   * @brief Thread of the simulated boards in dummy mode.
+   */
+  monopod_drivers::ThreadPolicy simulation;
+
+  /**
+   * @brief Writer thread of the telemetry recorder and thread of the
+   * SharedMemoryBridge. They only serve the users, so they run below the
+   * threads talking to the boards by default.
+   */
+  monopod_drivers::ThreadPolicy telemetry =
+      monopod_drivers::ThreadPolicy::with_priority(5);
+  monopod_drivers::ThreadPolicy bridge =
+      monopod_drivers::ThreadPolicy::with_priority(10);
+
+  /**
+   * @brief Memory policy applied before any thread is spawned.
+   */
+  monopod_drivers::MemoryPolicy memory;
+};
+
+/**
+ * @brief MonopodConfig holds the configuration of the connection to the
+ * robot.
+ */
+struct MonopodConfig {
+  /**
+   * @brief Name of the CAN interface each ControlBoardsInterface::BoardIndex
+   * is connected to. Boards sharing an interface share the same CanBus.
+   */
+  std::array<std::string, ControlBoardsInterface::board_count> can_interfaces =
+      {{"can0", "can0", "can0"}};
+
+  /**
+   * @brief CPU the receive threads of each CAN interface are pinned to. The
+   * interfaces which are not listed are not pinned.
+   */
+  std::unordered_map<std::string, int> receive_cpus;
+
+  /**
+   * @brief How each CAN interface sends its frames, by default from a queue
+   * such that setting the torques never waits for the network.
+   */
+  monopod_drivers::CanBusTransmitConfig can_transmit;
+
+  /**
+   * @brief If not empty and not in dummy mode, the boards decode this CAN log
+   * (see CanBusReplay::load) instead of talking to the robot. Every board is
+   * mapped onto the replayed bus, the frames sent go nowhere.
+   */
+  std::string replay_log;
+
+  /**
+   * @brief Playback speed of the replay_log, see CanBusReplay.
+   */
+  double replay_speed = 1.0;
+
+  /**
+   * @brief Period (s) of the safety loop checking the joint limits. If 0 the
+   * limits are checked every time the boards send new measurements.
+   */
+  double safety_period_s = 0.001;
+
+  /**
+   * @brief Model of the robot simulated in dummy mode.
+   */
+  monopod_drivers::SimulationParameters simulation;
+
+  /**
+   * @brief Length of the time series of the boards and of the CAN buses, use
+   * monopod_drivers::HistoryConfig::latest_only() when only the newest values
+   * are read.
+   */
+  monopod_drivers::HistoryConfig history;
+
+  /**
+   * @brief Measurements streamed by the boards, everything by default. The
+   * positions of the joints of the selected Mode must be subscribed. The
+   * limits of the measurements which are not subscribed are not checked by
+   * the safety_loop.
+   */
+  monopod_drivers::StreamingConfig streaming;
+
+  /**
+   * @brief Scheduling of the threads and memory policy, see RealtimeConfig.
+   */
+  RealtimeConfig realtime;
+
+  /**
+   * @brief How long initialize waits for the boards to be ready.
+   */
+  monopod_drivers::ReadinessConfig readiness;
+};
+
+/**
+ * @brief StateSnapshot holds the state of every joint of the monopod taken
+ * from one coherent board snapshot. It is indexed by JointNamesIndex and is
+ * meant to be owned and reused by the caller, see Monopod::read_state.
+ */
+struct alignas(64) StateSnapshot {
+  /**
+   * @brief Joint positions (rad).
+   */
+  std::array<double, NUMBER_JOINTS> position;
+
+  /**
+   * @brief Joint velocities (rad/s).
+   */
+  std::array<double, NUMBER_JOINTS> velocity;
+
+  /**
+   * @brief Joint accelerations (rad/s^2).
+   */
+  std::array<double, NUMBER_JOINTS> acceleration;
+
+  /**
+   * @brief Measured joint torques (Nm), NaN for the encoder only joints.
+   */
+  std::array<double, NUMBER_JOINTS> torque;
+
+  /**
+   * @brief Bit (1 << JointNamesIndex) is set if the joint is active. The data
+   * of the inactive joints is NaN.
+   */
+  uint32_t valid_joints;
+
+  /**
+   * @brief Number of frames decoded by the boards when the snapshot was
+   * published.
+   */
+  uint64_t frame_count;
+
+  /**
+   * @brief Serialize the snapshot, used to share it between processes.
+   */
+  template <class Archive> void serialize(Archive &archive) {
+    for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+      archive(position[i], velocity[i], acceleration[i], torque[i]);
+    }
+    archive(valid_joints, frame_count);
+  }
+};
+
+/**
+ * @brief MonopodStats gathers the latencies along the path of the data, from
+ * the CAN frames received to the controls sent, and the timing of the
+ * real-time threads, see Monopod::get_stats.
+ */
+struct MonopodStats {
+  /**
+   * @brief Statistics of the boards and of the CAN buses.
+   */
+  monopod_drivers::BoardsStats boards;
+
+  /**
+   * @brief Age of the measurements when they are read, i.e. time between the
+   * publication of the snapshot by the boards and read_state.
+   */
+  monopod_drivers::LatencySummary read;
+
+  /**
+   * @brief Timing of the real-time threads of the sdk.
+   */
+  Vector<monopod_drivers::ThreadStats> threads;
+};
+
+/**
+ * @brief SafetyLimits holds the limits of all the joints as flat arrays indexed
+ * by [Measurements][JointNamesIndex], such that all the joints are checked
+ * against a StateSnapshot in a single pass.
+ */
+struct alignas(64) SafetyLimits {
+  /**
+   * @brief Number of limited measurements: position, velocity and
+   * acceleration.
+   */
+  static constexpr size_t limit_count = 3;
+
+  /**
+   * @brief Construct a new SafetyLimits object without any limit.
+   */
+  SafetyLimits() {
+    for (size_t i = 0; i < limit_count; i++) {
+      min[i].fill(JointLimit::m);
+      max[i].fill(JointLimit::M);
+    }
+    checked_joints.fill(0);
+  }
+
+  /**
+   * @brief Check if every valid joint of the state is within [min, max). Only
+   * the measurements in checked_joints are checked, a NaN one is out of range.
+   *
+   * @param state is the state to be checked.
+   * @return bool true if in range, otherwise false.
+   */
+  bool contains(const StateSnapshot &state) const {
+    bool in_limits = true;
+    for (size_t j = 0; j < NUMBER_JOINTS; j++) {
+      const bool valid_joint = (state.valid_joints >> j) & 1u;
+      const bool position_ok =
+          !((checked_joints[position] >> j) & 1u) ||
+          (min[position][j] <= state.position[j] &&
+           state.position[j] < max[position][j]);
+      const bool velocity_ok =
+          !((checked_joints[velocity] >> j) & 1u) ||
+          (min[velocity][j] <= state.velocity[j] &&
+           state.velocity[j] < max[velocity][j]);
+      const bool acceleration_ok =
+          !((checked_joints[acceleration] >> j) & 1u) ||
+          (min[acceleration][j] <= state.acceleration[j] &&
+           state.acceleration[j] < max[acceleration][j]);
+      const bool joint_ok = position_ok & velocity_ok & acceleration_ok;
+      in_limits &= joint_ok || !valid_joint;
+    }
+    return in_limits;
+  }
+
+  /**
+   * @brief Lower limit of each measurement of each joint.
+   */
+  std::array<std::array<double, NUMBER_JOINTS>, limit_count> min;
+
+  /**
+   * @brief Upper limit of each measurement of each joint.
+   */
+  std::array<std::array<double, NUMBER_JOINTS>, limit_count> max;
+
+  /**
+   * @brief Bitmask of the joints of which each measurement is checked, i.e.
+   * streamed by the boards (see MonopodConfig::streaming).
+   */
+  std::array<uint32_t, limit_count> checked_joints;
+};
+
 /**
  * @brief Drivers for open sim2real monopod. Interfaces with the monopod TI
  * motors using monopod_drivers::BlmcJointModule. This class creates a real time
@@ -42,8 +316,14 @@ public:
    *
    * @param monopod_mode defines the task mode of the monopod. Can also specify
    * individual boards.
+   * @param dummy_mode if true no connection to the real robot is made, the
+   * robot is simulated instead, see config.simulation.
+   * @param config defines how the boards are connected.
+   * @throw monopod_drivers::BoardsNotReadyError if the boards are not ready
+   * before config.readiness.timeout_s.
    */
-  bool initialize(Mode monopod_mode, bool dummy_mode = false);
+  bool initialize(Mode monopod_mode, bool dummy_mode = false,
+                  const MonopodConfig &config = MonopodConfig());
 
   /**
    * @brief is the monopod sdk Initialized?.
@@ -64,18 +344,46 @@ public:
    * This requires the board to be initialized in any mode which has active
    * motors. Additionally this function will pause the limit checks and will
    * reset the board before executing the position control. This is to allow
-   * homing from outside the limits.
+   * homing from outside the limits. Nothing happens while calibrating.
    */
   void goto_position(const double &hip_home_position = 0,
                      const double &knee_home_position = 0);
 
+  /**
+   * @brief Queue a leg trajectory through a list of waypoints and return
+   * right away, see Leg::queue_trajectory. The limit checks stay active. The
+   * leg holds the last waypoint until stop_trajectory is called.
+   *
+   * @param waypoints are [hip, knee] positions (rad).
+   * @param average_speed_rad_per_sec (rad/sec) of the slowest joint.
+   * @return bool true if the trajectory was queued.
+   */
+  bool queue_trajectory(
+      const Vector<std::array<double, NUMBER_LEG_JOINTS>> &waypoints,
+      const double &average_speed_rad_per_sec = 1.0);
+
+  /**
+   * @brief Has every queued waypoint been reached?
+   */
+  bool is_trajectory_done() const;
+
+  /**
+   * @brief Stop the trajectory, drop the queued waypoints and release the
+   * leg.
+   */
+  void stop_trajectory();
+
   /**
    * @brief This method is a helper class to hold the position the leg was in
    * when the function was called. This function will only change the state if
    * the motor board is active. otherwise nothing will happen. When holding the
-   * monopod wll be a read only state until the holding is killed.
+   * monopod wll be a read only state until the holding is killed. Nothing
+   * happens while calibrating.
+   *
+   * @param period_s is the period (s) of the position controller, it runs on
+   * new measurements hence at most at the rate of the boards (1 kHz).
    */
-  void hold_position();
+  void hold_position(const double &period_s = 0.001);
 
   /**
    * @brief Is the monopod holding the current leg position?
@@ -88,14 +396,40 @@ public:
   void stop_hold_position();
 
   /**
-   * @brief Calibrate the Encoders.
+   * @brief Calibrate the Encoders and wait for the end of the calibration, see
+   * start_calibration.
    *
    * @param hip_home_offset_rad hip offset from found encoder index 0 (rad)
    * @param knee_home_offset_rad knee offset from found encoder index 0
    * (rad)
+   * @param config sets the speed profile of the homing.
    */
   void calibrate(const double &hip_home_offset_rad = 0,
-                 const double &knee_home_offset_rad = 0);
+                 const double &knee_home_offset_rad = 0,
+                 const HomingConfig &config = HomingConfig());
+
+  /**
+   * @brief Start calibrating the Encoders without blocking: both leg joints
+   * search their encoder index at the same time and then go to zero. The
+   * safety loop keeps running, only the position limits of the leg joints are
+   * ignored until the calibration is over as their zero is being set.
+   *
+   * @param hip_home_offset_rad hip offset from found encoder index 0 (rad)
+   * @param knee_home_offset_rad knee offset from found encoder index 0
+   * (rad)
+   * @param config sets the speed profile of the homing.
+   * @return bool false if the leg is busy, e.g. holding or calibrating.
+   */
+  bool start_calibration(const double &hip_home_offset_rad = 0,
+                         const double &knee_home_offset_rad = 0,
+                         const HomingConfig &config = HomingConfig());
+
+  /**
+   * @brief Get the progress of the calibration.
+   *
+   * @return HomingProgress
+   */
+  HomingProgress get_calibration_progress() const;
 
   /**
    * @brief Get model name
@@ -159,9 +493,10 @@ public:
    * @brief Set the torque targets for all joint indexes. Return a bool whether
    * successful.
    *
-   * @warning  Note: if it fails the behaviour is undefined. For example if
-   * first 3 joints are right but one bad index it will updatethe good ones the
-   * fail on the bad one.
+   * The torques of all the joints are staged first and then committed at once,
+   * such that the motor board receives a single control frame holding a
+   * consistent set of currents. If any of the joint indexes is invalid nothing
+   * is staged nor sent.
    *
    * @param torque_targets vector of desired torque targets for indexed joints
    * @param joint_indexes names of the joints we want to access
@@ -170,6 +505,31 @@ public:
   bool set_torque_targets(const Vector<double> &torque_targets,
                           const Vector<int> &joint_indexes = {});
 
+  /**
+   * @brief Same as set_torque_targets, but nothing is staged and false is
+   * returned instead of asserting when the monopod is not running, e.g. while
+   * it is holding. This is meant for the threads which do not own the
+   * monopod, like the SharedMemoryBridge.
+   *
+   * @param torque_targets vector of desired torque targets for indexed joints
+   * @param joint_indexes names of the joints we want to access
+   * @return bool whether setting the value was successfull
+   */
+  bool try_set_torque_targets(const Vector<double> &torque_targets,
+                              const Vector<int> &joint_indexes = {});
+
+  /**
+   * @brief Set the torque targets of the hip and of the knee from a caller
+   * owned buffer, e.g. a NumPy array, without any copy nor allocation. See
+   * above for the staging of the torques.
+   *
+   * @param torque_targets holds NUMBER_LEG_JOINTS torques (Nm) in the order
+   * of JointNamesIndex.
+   * @return bool whether setting the value was successfull
+   */
+  bool
+  set_torque_targets(const Eigen::Ref<const Eigen::VectorXd> &torque_targets);
+
   /**
    * Set the PID parameters of the joint.
    *
@@ -293,6 +653,16 @@ public:
   std::optional<Vector<double>>
   get_torque_targets(const Vector<int> &joint_indexes = {}) const;
 
+  /**
+   * @brief Get the torques of the hip and of the knee into a caller owned
+   * buffer, without any allocation.
+   *
+   * @param torque_targets is set to NUMBER_LEG_JOINTS torques (Nm) in the
+   * order of JointNamesIndex.
+   * @return bool false if the size of the buffer is not NUMBER_LEG_JOINTS.
+   */
+  bool get_torque_targets(Eigen::Ref<Eigen::VectorXd> torque_targets) const;
+
   /**
    * @brief Get the position of joint
    *
@@ -348,6 +718,90 @@ public:
   std::optional<Vector<double>>
   get_accelerations(const Vector<int> &joint_indexes = {}) const;
 
+  /**
+   * @brief Get the positions of all the joints into a caller owned buffer,
+   * e.g. a NumPy array, without any allocation. The values are indexed by
+   * JointNamesIndex and are NaN for the inactive joints, see read_state.
+   *
+   * @param positions is set to NUMBER_JOINTS positions (rad).
+   * @return bool false if the size of the buffer is not NUMBER_JOINTS.
+   */
+  bool get_positions(Eigen::Ref<Eigen::VectorXd> positions) const;
+
+  /**
+   * @brief Get the velocities of all the joints, see above.
+   *
+   * @param velocities is set to NUMBER_JOINTS velocities (rad/s).
+   * @return bool false if the size of the buffer is not NUMBER_JOINTS.
+   */
+  bool get_velocities(Eigen::Ref<Eigen::VectorXd> velocities) const;
+
+  /**
+   * @brief Get the accelerations of all the joints, see above.
+   *
+   * @param accelerations is set to NUMBER_JOINTS accelerations (rad/s^2).
+   * @return bool false if the size of the buffer is not NUMBER_JOINTS.
+   */
+  bool get_accelerations(Eigen::Ref<Eigen::VectorXd> accelerations) const;
+
+  /**
+   * @brief Read the state of all the joints at once. The state is copied from
+   * the newest snapshot published by the boards, hence all values come from
+   * the same point in time. This neither allocates nor locks and is meant to
+   * be called once per control tick.
+   *
+   * @param state is filled with the newest joint state.
+   */
+  void read_state(StateSnapshot &state) const;
+
+  /**
+   * @brief Block until the boards sent new measurements since the last call,
+   * such that a control loop runs in phase with the sensor stream. Returns
+   * immediately if new measurements were already received. The measurements
+   * are tracked through the hip position if the motor board is active, and
+   * through the position of the first active encoder otherwise.
+   *
+   * @param timeout_s is the maximum time to wait (s), NaN waits forever.
+   * @return bool true if new measurements are available, false on timeout.
+   */
+  bool wait_for_new_state(const double &timeout_s = 0.01);
+
+  /**
+   * @brief Record the CAN traffic and the decoded measurements to a binary
+   * file, see monopod_drivers::TelemetryRecord for the format. This does not
+   * disturb the control: the real-time threads only push fixed size records
+   * in a preallocated buffer which is written by a low priority thread.
+   *
+   * @param file_name is the path of the file, overwritten if it exists.
+   * @return bool true if the recording started.
+   */
+  bool start_recording(const std::string &file_name);
+
+  /**
+   * @brief Stop recording and write the buffered records.
+   *
+   * @return uint64_t the number of records dropped because the writer did not
+   * keep up.
+   */
+  uint64_t stop_recording();
+
+  /**
+   * @brief Get the latencies and the counters collected since initialize. The
+   * pipeline is: frame timestamped by the kernel, CanBus (receive), boards
+   * (decode), read_state (read), set_control to frame sent (control).
+   *
+   * @return MonopodStats
+   */
+  MonopodStats get_stats() const;
+
+  /**
+   * @brief Get the scheduling of the threads given to initialize, e.g. for
+   * the SharedMemoryBridge to follow it.
+   *
+   * @return const RealtimeConfig&
+   */
+  const RealtimeConfig &get_realtime_config() const { return realtime_; }
+
 private:
   /**
    * @brief Possible monopod states.
@@ -362,26 +816,43 @@ private:
     //! Read only mode. Can only read position and set values of observation
     //! limits.
     READ_ONLY,
-  } current_state_;
+  };
+
+  /**
+   * @brief The current state, also read by the threads calling
+   * try_set_torque_targets.
+   */
+  std::atomic<MonopodState> current_state_;
 
   /**
    * @brief this function is just a wrapper around the actual safety_loop
    * function, such that it can be spawned as a posix thread.
    */
   static THREAD_FUNCTION_RETURN_TYPE safety_loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
     ((Monopod *)(instance_pointer))->safety_loop();
     return THREAD_FUNCTION_RETURN_VALUE;
   }
 
   /**
-   * @brief this is a simple control safety_loop which runs at a kilohertz.
-   *
-   * it reads the measurement from the analog sensor, in this case the
-   * slider. then it scales it and sends it as the current target to
-   * the motor.
+   * @brief This is the safety_loop checking the joint limits. It runs at the
+   * MonopodConfig::safety_period_s or every time the boards send new
+   * measurements. Every check reads one StateSnapshot and the published
+   * SafetyLimits, hence it never locks nor allocates.
    */
   void safety_loop();
 
+  /**
+   * @brief Set the limit of a joint both in the joint module and in the
+   * limits checked by the safety_loop.
+   *
+   * @param index is the measurement to be limited.
+   * @param joint_index is the joint to be limited.
+   * @param limit
+   */
+  void set_joint_limit(const Measurements &index, const int &joint_index,
+                       const JointLimit &limit);
+
   /**
    * @brief Simple helper method to serialized getting of data.
    *
@@ -398,7 +869,7 @@ private:
     Vector<double> data;
     data.reserve(jointSerialization.size());
     for (auto &joint_index : jointSerialization) {
-      if (Contains(encoder_joint_indexing, joint_index)) {
+      if (is_encoder_joint(joint_index)) {
         data.push_back(getJointData(joint_index));
       } else {
         return std::nullopt;
@@ -426,18 +897,28 @@ private:
     /* create motors here*/
     auto motor = std::make_shared<monopod_drivers::Motor>(board_, joint_index);
     /* motor joint modules */
-    return std::make_shared<MotorJointModule>(joint_index, motor, 0.025, 9.0,
-                                              0.0, true);
+    return std::make_shared<MotorJointModule>(
+        joint_index, motor, LEG_MOTOR_CONSTANT, LEG_GEAR_RATIO, 0.0, true);
   }
 
   /**
-   * @brief Template helper checking if vector contains an element.
+   * @brief Is the joint read by an encoder in the current mode?
+   *
+   * @param joint_index is any integer, not only a JointNamesIndex.
    */
-  template <typename T>
-  bool Contains(const Vector<T> &Vec, const T &Element) const {
-    if (std::find(Vec.begin(), Vec.end(), Element) != Vec.end())
-      return true;
-    return false;
+  bool is_encoder_joint(const int &joint_index) const {
+    return joint_index >= 0 && joint_index < NUMBER_JOINTS &&
+           ((encoder_joints_ >> joint_index) & 1u);
+  }
+
+  /**
+   * @brief Is the joint actuated in the current mode?
+   *
+   * @param joint_index is any integer, not only a JointNamesIndex.
+   */
+  bool is_motor_joint(const int &joint_index) const {
+    return joint_index >= 0 && joint_index < NUMBER_JOINTS &&
+           ((motor_joints_ >> joint_index) & 1u);
   }
 
 public:
@@ -477,6 +958,41 @@ private:
    */
   bool pause_safety_loop;
 
+  /**
+   * @brief Period (s) of the safety_loop, 0 means every new measurement.
+   */
+  double safety_period_s_;
+
+  /**
+   * @brief Scheduling of the threads, see MonopodConfig::realtime.
+   */
+  RealtimeConfig realtime_;
+
+  /**
+   * @brief Deadlines of the safety_loop.
+   */
+  DeadlineMonitor safety_monitor_;
+
+  /**
+   * @brief Age of the snapshots when read by read_state.
+   */
+  mutable LatencyHistogram read_latency_;
+
+  /**
+   * @brief The limits of all joints, updated by the setters only.
+   */
+  SafetyLimits safety_limits_;
+
+  /**
+   * @brief The mutex door serializing the updates of safety_limits_.
+   */
+  std::mutex safety_limits_door_;
+
+  /**
+   * @brief Publishes safety_limits_ to the safety_loop.
+   */
+  SeqLock<SafetyLimits> published_safety_limits_;
+
   /**
    * @brief Determines if the joint is in dummy mode. (no connection to real
    * robot)
@@ -484,9 +1000,9 @@ private:
   bool dummy_mode_;
 
   /**
-   * @brief Canbus connection.
+   * @brief Canbus connections, one per CAN interface, or the replayed bus.
    */
-  Ptr<monopod_drivers::CanBus> can_bus_;
+  Vector<Ptr<monopod_drivers::CanBusInterface>> can_buses_;
 
   /**
    * @brief Canbus ControlBoards. This maintains connection with the canbus and
@@ -496,20 +1012,34 @@ private:
   Ptr<monopod_drivers::ControlBoardsInterface> board_;
 
   /**
-   * @brief Holds encoder joint modules for each active joint.
+   * @brief Records the traffic of board_ on demand.
    */
-  std::unordered_map<int, Ptr<EncoderJointModule>> encoders_;
+  Ptr<monopod_drivers::TelemetryRecorder> recorder_;
+
+  /**
+   * @brief Holds encoder joint modules indexed by JointNamesIndex, nullptr
+   * for the inactive joints.
+   */
+  std::array<Ptr<EncoderJointModule>, NUMBER_JOINTS> encoders_;
 
   /**
    * @brief Read Joint names indexed same as enumerator for encoders. All valid
-   * joints should be defined here.
+   * joints should be defined here. This is the default serialization of the
+   * getters for the current mode.
    */
   Vector<int> encoder_joint_indexing;
 
   /**
-   * @brief Holds motor joint modules for each active controllable joint.
+   * @brief Bit (1 << JointNamesIndex) is set for every joint of
+   * encoder_joint_indexing.
+   */
+  uint32_t encoder_joints_ = 0;
+
+  /**
+   * @brief Holds motor joint modules indexed by JointNamesIndex, nullptr for
+   * the joints which are not controllable.
    */
-  std::unordered_map<int, Ptr<MotorJointModule>> motors_;
+  std::array<Ptr<MotorJointModule>, NUMBER_JOINTS> motors_;
 
   /**
    * @brief Write Joint names indexed same as enumerator for actuators.  All
@@ -517,6 +1047,12 @@ private:
    */
   Vector<int> motor_joint_indexing;
 
+  /**
+   * @brief Bit (1 << JointNamesIndex) is set for every joint of
+   * motor_joint_indexing.
+   */
+  uint32_t motor_joints_ = 0;
+
   /**
    * @brief robot Leg interface object. This is used for calibration and coupled
    * actions like goto position. I m not sure if this is how we should handle
@@ -524,6 +1060,16 @@ private:
    */
   std::unique_ptr<monopod_drivers::Leg> leg_;
 
+  /**
+   * @brief Measurement tracked by wait_for_new_state().
+   */
+  Ptr<const ScalarTimeseries> state_trigger_;
+
+  /**
+   * @brief Newest timeindex of state_trigger_ seen by wait_for_new_state().
+   */
+  Index state_timeindex_;
+
 }; // end class Monopod definition
 
 } // namespace monopod_drivers
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <Eigen/Dense>
+
+#include "monopod_sdk/common_header.hpp"
+#include "monopod_sdk/monopod_drivers/devices/simulated_boards.hpp"
+#include "monopod_sdk/monopod_drivers/utils/worker_pool.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief MonopodArray simulates many monopods in lockstep in one process, e.g.
+ * to collect the rollouts of a learning algorithm.
+ *
+ * Every robot runs the model of the SimulatedControlBoards, the states are
+ * stored as structures of arrays and the robots are stepped in parallel by a
+ * WorkerPool. The torques and the states are exchanged in single calls as
+ * robot_count x joints matrices, one row per robot, in the frame of the
+ * joints of a Monopod and with the columns in the order of JointNamesIndex.
+ * The torques go through the same conversion to currents as a Monopod, i.e.
+ * they saturate at the same current. The robots are always stepped by the
+ * caller, SimulationParameters::real_time is ignored.
+ */
+class MonopodArray {
+public:
+  /**
+   * @brief Matrix of one value per joint and per robot.
+   */
+  typedef Eigen::Matrix<double, Eigen::Dynamic, NUMBER_JOINTS, Eigen::RowMajor>
+      JointMatrix;
+
+  /**
+   * @brief Matrix of one value per leg joint (hip, knee) and per robot.
+   */
+  typedef Eigen::Matrix<double, Eigen::Dynamic, NUMBER_LEG_JOINTS,
+                        Eigen::RowMajor>
+      LegMatrix;
+
+  /**
+   * @brief State of the joints of one robot.
+   */
+  typedef Eigen::Matrix<double, NUMBER_JOINTS, 1> JointVector;
+
+  /**
+   * @brief Safe mode flag of each robot.
+   */
+  typedef Eigen::Array<bool, Eigen::Dynamic, 1> RobotMask;
+
+  /**
+   * @brief Construct a new MonopodArray object, all the robots at rest with
+   * their joints at zero.
+   *
+   * @param robot_count is the number of simulated robots.
+   * @param parameters of the model shared by all the robots.
+   * @param worker_count is the number of threads stepping the robots, the
+   * calling one included. 0 uses one per hardware thread.
+   * @throw std::invalid_argument if robot_count is 0.
+   */
+  MonopodArray(const size_t &robot_count,
+               const SimulationParameters &parameters = SimulationParameters(),
+               const size_t &worker_count = 0);
+
+  /**
+   * @brief Set the torques applied by the leg motors of all the robots until
+   * the next call. The robots in safe mode keep a zero torque.
+   *
+   * @param torques is robot_count x NUMBER_LEG_JOINTS (Nm), hip then knee.
+   * @throw std::invalid_argument if the size does not match.
+   */
+  void set_torque_targets(const Eigen::Ref<const LegMatrix> &torques);
+
+  /**
+   * @brief Advance all the robots.
+   *
+   * @param step_count is the number of time steps.
+   */
+  void step(const size_t &step_count = 1);
+
+  /**
+   * @brief Get the state of all the robots.
+   *
+   * @param positions is set to the positions of the joints (rad).
+   * @param velocities is set to the velocities of the joints (rad/s).
+   * @param accelerations is set to the accelerations of the joints (rad/s^2).
+   * @throw std::invalid_argument if a size does not match.
+   */
+  void get_state(Eigen::Ref<JointMatrix> positions,
+                 Eigen::Ref<JointMatrix> velocities,
+                 Eigen::Ref<JointMatrix> accelerations) const;
+
+  /**
+   * @brief Put all the robots back at rest with the joints at zero and leave
+   * the safe mode. The time is not reset.
+   */
+  void reset();
+
+  /**
+   * @brief Put one robot back at rest and leave the safe mode.
+   *
+   * @param robot
+   * @param positions of the joints (rad).
+   * @throw std::invalid_argument if the robot does not exist.
+   */
+  void reset(const size_t &robot, const JointVector &positions);
+
+  /**
+   * @brief Set the position limits of a joint for all the robots. A robot
+   * leaving them goes to safe mode: its torques are zeroed until it is reset,
+   * like a Monopod does.
+   *
+   * @param joint_index is the JointNamesIndex.
+   * @param min (rad)
+   * @param max (rad)
+   * @throw std::invalid_argument if the joint does not exist or min > max.
+   */
+  void set_position_limit(const int &joint_index, const double &min,
+                          const double &max);
+
+  /**
+   * Getters
+   */
+
+  /**
+   * @brief Get the number of robots.
+   *
+   * @return size_t
+   */
+  size_t get_robot_count() const { return robot_count_; }
+
+  /**
+   * @brief Get the simulated time (s), the same for all the robots.
+   *
+   * @return double
+   */
+  double get_time() const { return step_count_ * parameters_.time_step; }
+
+  /**
+   * @brief Get which robots are in safe mode.
+   *
+   * @return const RobotMask&
+   */
+  const RobotMask &get_safemode() const { return is_safemode_; }
+
+private:
+  /**
+   * @brief Step the robots [begin, end) and check their limits.
+   *
+   * @param begin
+   * @param end
+   * @param step_count
+   */
+  void step_robots(const size_t &begin, const size_t &end,
+                   const size_t &step_count);
+
+  /**
+   * @brief Number of robots.
+   */
+  const size_t robot_count_;
+
+  /**
+   * @brief The simulated model.
+   */
+  const SimulationParameters parameters_;
+
+  /**
+   * @brief State of the robots, indexed by the joints of the model then by
+   * the robots, see SimulationStateView.
+   */
+  std::array<Eigen::VectorXd, NUMBER_JOINTS> position_;
+  std::array<Eigen::VectorXd, NUMBER_JOINTS> velocity_;
+  std::array<Eigen::VectorXd, NUMBER_JOINTS> acceleration_;
+
+  /**
+   * @brief Currents of the hip and knee motors of the robots.
+   */
+  std::array<Eigen::VectorXd, NUMBER_LEG_JOINTS> current_;
+
+  /**
+   * @brief Position limits of each joint, indexed by JointNamesIndex.
+   */
+  std::array<std::pair<double, double>, NUMBER_JOINTS> position_limits_;
+
+  /**
+   * @brief Is each robot in safe mode?
+   */
+  RobotMask is_safemode_;
+
+  /**
+   * @brief Number of steps since the construction.
+   */
+  uint64_t step_count_;
+
+  /**
+   * @brief The threads stepping the robots.
+   */
+  WorkerPool workers_;
+};
+
+} // namespace monopod_drivers
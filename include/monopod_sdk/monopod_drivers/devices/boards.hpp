@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <real_time_tools/thread.hpp>
 #include <real_time_tools/timer.hpp>
@@ -10,7 +17,11 @@
 #include "monopod_sdk/common_header.hpp"
 #include "monopod_sdk/monopod_drivers/devices/can_bus.hpp"
 #include "monopod_sdk/monopod_drivers/devices/device_interface.hpp"
+#include "monopod_sdk/monopod_drivers/devices/telemetry_recorder.hpp"
 #include "monopod_sdk/monopod_drivers/utils/os_interface.hpp"
+#include "monopod_sdk/monopod_drivers/utils/q24_codec.hpp"
+#include "monopod_sdk/monopod_drivers/utils/seqlock.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
 
 namespace monopod_drivers {
 //==============================================================================
@@ -205,6 +216,118 @@ public:
   }
 };
 
+/**
+ * @brief BoardsStats reports the time spent by the frames between the boards
+ * and the users of the ControlBoardsInterface. The latencies are all measured
+ * on the wall clock, see get_wall_time_ns.
+ */
+struct BoardsStats {
+  /**
+   * @brief Number of frames decoded and published in the snapshot.
+   */
+  uint64_t decoded_frames = 0;
+
+  /**
+   * @brief Number of received frames which are not decoded by the boards.
+   */
+  uint64_t unknown_frames = 0;
+
+  /**
+   * @brief Number of received frames dropped because their payload is invalid,
+   * e.g. an encoder index for a motor the board does not have.
+   */
+  uint64_t invalid_frames = 0;
+
+  /**
+   * @brief Time between the timestamp of a frame and the publication of its
+   * content in the snapshot. This includes the reception by the CanBus, see
+   * CanBusStats::receive.
+   */
+  LatencySummary decode;
+
+  /**
+   * @brief Time between the newest set_control and the controls being handed
+   * to the network.
+   */
+  LatencySummary control;
+
+  /**
+   * @brief Statistics of each of the CAN buses, empty if the boards are not
+   * on a CAN network.
+   */
+  Vector<CanBusStats> can_buses;
+};
+
+/**
+ * @brief ReadinessConfig sets how the boards wait to be ready, see
+ * ControlBoardsInterface::wait_until_ready. The wait wakes up on every status
+ * message, the reset commands are only sent again while the boards stay
+ * silent or not ready, with an exponential backoff.
+ */
+struct ReadinessConfig {
+  /**
+   * @brief Maximum time to wait for the boards (s).
+   */
+  double timeout_s = 10.0;
+
+  /**
+   * @brief Time before the first reset is repeated (s).
+   */
+  double initial_retry_s = 0.02;
+
+  /**
+   * @brief Longest time between two resets (s).
+   */
+  double max_retry_s = 0.5;
+
+  /**
+   * @brief Factor applied to the time between two resets after each of them.
+   */
+  double backoff_factor = 2.0;
+};
+
+/**
+ * @brief BoardsNotReadyError is thrown when the active boards are not ready
+ * before the timeout of the ReadinessConfig. It tells which boards failed, the
+ * indexes are ControlBoardsInterface::BoardIndex.
+ */
+class BoardsNotReadyError : public std::runtime_error {
+public:
+  /**
+   * @brief Construct a new BoardsNotReadyError object
+   *
+   * @param silent_boards see below.
+   * @param not_ready_boards see below.
+   * @param motor_board_error see below.
+   * @param message describes the error.
+   */
+  BoardsNotReadyError(const Vector<int> &silent_boards,
+                      const Vector<int> &not_ready_boards,
+                      const uint8_t &motor_board_error,
+                      const std::string &message)
+      : std::runtime_error(message), silent_boards(silent_boards),
+        not_ready_boards(not_ready_boards),
+        motor_board_error(motor_board_error) {}
+
+  /**
+   * @brief Active boards which never sent a status message.
+   */
+  Vector<int> silent_boards;
+
+  /**
+   * @brief Active boards whose newest status is not ready.
+   */
+  Vector<int> not_ready_boards;
+
+  /**
+   * @brief Error code of the newest status of the motor board, see
+   * BoardStatus::ErrorCodes.
+   */
+  uint8_t motor_board_error;
+};
+
+struct BoardsSnapshot;
+
 //==============================================================================
 /**
  * @brief ControlBoardsInterface declares an API to inacte with a ControlBoards.
@@ -383,6 +506,21 @@ public:
    */
   virtual Ptr<const CommandTimeseries> get_sent_command() const = 0;
 
+  /**
+   * @brief Get a coherent copy of the newest measurements and status of all
+   * the boards. This never locks nor allocates.
+   *
+   * @param snapshot is filled with the newest published data.
+   */
+  virtual void get_snapshot(BoardsSnapshot &snapshot) const = 0;
+
+  /**
+   * @brief Get the statistics of the communication with the boards.
+   *
+   * @return BoardsStats
+   */
+  virtual BoardsStats get_stats() const = 0;
+
   /**
    * Setters
    */
@@ -396,6 +534,14 @@ public:
    */
   virtual void set_active_board(const int &index) = 0;
 
+  /**
+   * @brief Set the recorder the CAN traffic and the decoded measurements are
+   * handed to. This is meant to be called once, while initializing.
+   *
+   * @param recorder is kept alive as long as the boards.
+   */
+  virtual void set_recorder(Ptr<TelemetryRecorder> recorder) = 0;
+
   /**
    * @brief set_control save the control internally. In order to actaully send
    * the controls to the network please call "send_if_input_changed"
@@ -420,8 +566,12 @@ public:
 
   /**
    * @brief returns only once board and motors are ready.
+   *
+   * @param config sets the timeout and the retries.
+   * @throw BoardsNotReadyError if the boards are not ready in time.
    */
-  virtual void wait_until_ready() = 0;
+  virtual void
+  wait_until_ready(const ReadinessConfig &config = ReadinessConfig()) = 0;
 
   /**
    * This will cause the control to be forced into a "safemode" where the
@@ -443,6 +593,165 @@ public:
   virtual void reset() = 0;
 };
 
+//==============================================================================
+/**
+ * @brief BoardsSnapshot holds the newest value of every measurement and the
+ * newest status of every board. It is published as a whole by the boards such
+ * that a reader always gets data from one coherent point in time.
+ */
+struct alignas(64) BoardsSnapshot {
+  /**
+   * @brief Construct a new BoardsSnapshot object with no data.
+   */
+  BoardsSnapshot() : status(), frame_count(0), publish_time_ns(0) {
+    measurements.fill(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  /**
+   * @brief Newest value of each ControlBoardsInterface::MeasurementIndex. NaN
+   * as long as the measurement was never received.
+   */
+  std::array<double, ControlBoardsInterface::measurement_count> measurements;
+
+  /**
+   * @brief Newest status of each ControlBoardsInterface::BoardIndex.
+   */
+  std::array<BoardStatus, ControlBoardsInterface::board_count> status;
+
+  /**
+   * @brief Number of frames decoded when the snapshot was published.
+   */
+  uint64_t frame_count;
+
+  /**
+   * @brief Time the snapshot was published (ns), see get_wall_time_ns.
+   */
+  uint64_t publish_time_ns;
+};
+
+/**
+ * @brief HistoryConfig sets the number of elements kept by each group of time
+ * series of the boards. Deep histories are handy to inspect a run on the lab
+ * PC, while a controller which only reads the newest values can keep the
+ * memory and cache footprint of the boards to a minimum.
+ *
+ * Whatever the lengths, the newest measurements and status are always
+ * published through the lock free ControlBoardsInterface::get_snapshot.
+ */
+struct HistoryConfig {
+  /**
+   * @brief Length of the measurement time series.
+   */
+  size_t measurement_length = 1000;
+
+  /**
+   * @brief Length of the status time series.
+   */
+  size_t status_length = 1000;
+
+  /**
+   * @brief Length of the control and command time series to be sent.
+   */
+  size_t control_length = 1000;
+
+  /**
+   * @brief Length of the already sent control and command time series.
+   */
+  size_t sent_length = 1000;
+
+  /**
+   * @brief Length of the frame time series of each CanBus. The received
+   * frames are queued there until the boards decode them, so this is not
+   * only a history.
+   */
+  size_t frame_length = 1000;
+
+  /**
+   * @brief Get the configuration keeping only the newest value of every
+   * channel. The readers are expected to go through get_snapshot, the time
+   * series only hold a single element. The frames keep a short queue to
+   * absorb the latency of the decoding threads.
+   *
+   * @return HistoryConfig
+   */
+  static HistoryConfig latest_only() {
+    HistoryConfig history;
+    history.measurement_length = 1;
+    history.status_length = 1;
+    history.control_length = 1;
+    history.sent_length = 1;
+    history.frame_length = 64;
+    return history;
+  }
+
+  /**
+   * @brief Check that every time series keeps at least one element.
+   *
+   * @throw std::invalid_argument if one of the lengths is 0.
+   */
+  void validate() const {
+    if (measurement_length == 0 || status_length == 0 || control_length == 0 ||
+        sent_length == 0 || frame_length == 0) {
+      throw std::invalid_argument(
+          "every time series must keep at least one element.");
+    }
+  }
+};
+
+/**
+ * @brief StreamingConfig selects the measurements streamed by the boards. By
+ * default the boards stream everything, subscribing to the channels a
+ * controller actually reads frees bandwidth on the buses and the memory of
+ * the time series of the other channels.
+ *
+ * The boards only know of groups of channels: enabling the position of one
+ * joint streams the positions of all the joints of the boards, see
+ * CanBusControlBoards::get_stream_command. The channels which are not
+ * subscribed have no time series, but may still show up in the snapshots.
+ */
+struct StreamingConfig {
+  /**
+   * @brief Construct a new StreamingConfig object subscribing to every
+   * channel.
+   */
+  StreamingConfig() { measurements.fill(true); }
+
+  /**
+   * @brief Get the configuration subscribing to the given channels only.
+   *
+   * @param channels are ControlBoardsInterface::MeasurementIndex.
+   * @return StreamingConfig
+   * @throw std::invalid_argument if one of the channels does not exist.
+   */
+  static StreamingConfig only(const std::vector<int> &channels) {
+    StreamingConfig streaming;
+    streaming.measurements.fill(false);
+    for (const auto &channel : channels) {
+      if (channel < 0 || channel >= ControlBoardsInterface::measurement_count) {
+        throw std::invalid_argument("index needs to match one of the "
+                                    "measurements.");
+      }
+      streaming.measurements[channel] = true;
+    }
+    return streaming;
+  }
+
+  /**
+   * @brief Is every channel subscribed?
+   *
+   * @return bool
+   */
+  bool is_streaming_all() const {
+    return std::all_of(measurements.begin(), measurements.end(),
+                       [](const bool &measurement) { return measurement; });
+  }
+
+  /**
+   * @brief Is each ControlBoardsInterface::MeasurementIndex subscribed?
+   */
+  std::array<bool, ControlBoardsInterface::measurement_count> measurements;
+};
+
 /**
  * @brief Create a vector of pointers.
  *
@@ -474,10 +783,33 @@ public:
    * @brief Construct a new CanBusControlBoards object
    *
    * @param can_bus
-   * @param history_length
+   * @param history is the length of the time series, see HistoryConfig.
+   * @param streaming selects the measurements, see StreamingConfig.
    */
   CanBusControlBoards(std::shared_ptr<CanBusInterface> can_bus,
-                      const size_t &history_length = 1000,
+                      const HistoryConfig &history = HistoryConfig(),
+                      const StreamingConfig &streaming = StreamingConfig(),
+                      const int &control_timeout_ms = 100);
+
+  /**
+   * @brief Construct a new CanBusControlBoards object communicating with the
+   * boards over several CAN buses. The frames of each bus are decoded by a
+   * dedicated real-time thread such that a busy bus never delays the others.
+   *
+   * @param can_buses are the buses the boards are connected to.
+   * @param board_buses is the index in can_buses of the bus of each
+   * BoardIndex.
+   * @param decode_threads is the scheduling of the decoding thread of each
+   * bus, the missing ones get the default ThreadPolicy.
+   * @param history is the length of the time series, see HistoryConfig.
+   * @param streaming selects the measurements, see StreamingConfig.
+   * @param control_timeout_ms
+   */
+  CanBusControlBoards(const Vector<std::shared_ptr<CanBusInterface>> &can_buses,
+                      const std::array<int, board_count> &board_buses,
+                      const Vector<ThreadPolicy> &decode_threads = {},
+                      const HistoryConfig &history = HistoryConfig(),
+                      const StreamingConfig &streaming = StreamingConfig(),
                       const int &control_timeout_ms = 100);
 
   /**
@@ -494,7 +826,8 @@ public:
    *
    * @param index is the kind of measurement we are insterested in.
    * @return Ptr<const ScalarTimeseries> is the list of the last measurements
-   * acquiered from the CAN card.
+   * acquiered from the CAN card, nullptr if the measurement is not
+   * subscribed, see StreamingConfig.
    */
   virtual Ptr<const ScalarTimeseries> get_measurement(const int &index) const {
     return measurement_[index];
@@ -548,6 +881,22 @@ public:
     return sent_command_;
   }
 
+  /**
+   * @brief Get the newest snapshot published by the receive loop, see
+   * ControlBoardsInterface::get_snapshot
+   *
+   * @param snapshot
+   */
+  virtual void get_snapshot(BoardsSnapshot &snapshot) const;
+
+  /**
+   * @brief Get the statistics of the communication, see
+   * ControlBoardsInterface::get_stats
+   *
+   * @return BoardsStats
+   */
+  virtual BoardsStats get_stats() const;
+
   /**
    * Setters
    */
@@ -561,6 +910,13 @@ public:
    */
   virtual void set_active_board(const int &index);
 
+  /**
+   * @brief Set the recorder, see ControlBoardsInterface::set_recorder
+   *
+   * @param recorder
+   */
+  virtual void set_recorder(Ptr<TelemetryRecorder> recorder);
+
   /**
    * @brief Set the controls, see ControlBoardsInterface::set_control
    *
@@ -569,6 +925,7 @@ public:
    */
   virtual void set_control(const double &control, const int &index) {
     control_[index]->append(control);
+    control_time_ns_.store(get_wall_time_ns(), std::memory_order_relaxed);
   }
 
   /**
@@ -586,9 +943,15 @@ public:
   virtual void send_if_input_changed();
 
   /**
-   * @brief returns only once board and motors are ready.
+   * @brief returns only once board and motors are ready, see
+   * ControlBoardsInterface::wait_until_ready. Returns without sending any
+   * command if they already are.
+   *
+   * @param config sets the timeout and the retries.
+   * @throw BoardsNotReadyError if the boards are not ready in time.
    */
-  virtual void wait_until_ready();
+  virtual void
+  wait_until_ready(const ReadinessConfig &config = ReadinessConfig());
 
   /**
    * This will cause the control to reset the "safemode" if the control is
@@ -603,11 +966,10 @@ public:
    * control is set to zero then held constant until reset.
    */
   virtual void enter_safemode() {
-    // Ensure we are not in safe mode for the pause motors to be able to send
-    // control.
-    is_safemode_ = false;
-    pause_motors();
+    // Block the controls of the users first, pause_motors sends its zero
+    // controls regardless of the safemode.
     is_safemode_ = true;
+    pause_motors();
   }
 
   /**
@@ -621,6 +983,14 @@ public:
    */
   bool is_ready();
 
+  /**
+   * @brief Get the first active board which is not ready.
+   *
+   * @return int the BoardIndex, board_count if all the active boards are
+   * ready.
+   */
+  int get_not_ready_board() const;
+
   /**
    * @brief Sets motors to Idle and sets the canbus control recieve timeout on
    * board to none until next action is sent.
@@ -634,78 +1004,154 @@ public:
 
   /// private methods ========================================================
 private:
+  struct BusContext;
+
   /**
-   * Useful converters
+   * @brief send the newest controls to the cards, unless in safemode.
    */
+  void send_newest_controls();
 
   /**
-   * @brief Converts from bytes to int32.
+   * @brief send controls to the cards, even in safemode.
    *
-   * @tparam T this is the type of the bytes convert.
-   * @param bytes The bytes value
-   * @return int32_t the output integer in int32.
+   * @param controls are the controls to be sent.
    */
-  template <typename T> int32_t bytes_to_int32(T bytes) {
-    return (int32_t)bytes[3] + ((int32_t)bytes[2] << 8) +
-           ((int32_t)bytes[1] << 16) + ((int32_t)bytes[0] << 24);
-  }
+  void send_controls(const std::array<double, control_count> &controls);
 
   /**
-   * @brief Convert from 24-bit normalized fixed-point to float.
+   * @brief send the latest commands to the cards.
    *
-   * @param qval is the floating base point.
-   * @return float is the converted value
    */
-  float q24_to_float(int32_t qval) { return ((float)qval / (1 << 24)); }
+  void send_newest_command();
 
   /**
-   * @brief Converts from float to 24-bit normalized fixed-point.
+   * @brief This is the helper function used for spawning the real time
+   * thread.
    *
-   * @param fval
-   * @return int32_t
+   * @param instance_pointer is the current object in this case.
+   * @return THREAD_FUNCTION_RETURN_TYPE depends on the current OS.
    */
-  int32_t float_to_q24(float fval) { return ((int)(fval * (1 << 24))); }
+  static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    BusContext *bus = (BusContext *)(instance_pointer);
+    bus->boards->loop(*bus);
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
 
   /**
-   * @brief Converts from qbytes to float
+   * @brief Is the loop that constently communicate with the network.
    *
-   * @tparam T the type of byte to manage
-   * @param qbytes the input value in bytes
-   * @return float the output value.
+   * @param bus is the context of the bus to be decoded.
    */
-  template <typename T> float qbytes_to_float(T qbytes) {
-    return q24_to_float(bytes_to_int32(qbytes));
+  void loop(BusContext &bus);
+
+  /**
+   * @brief Add a decoded measurement to the snapshot being assembled by the
+   * loop. It is appended to its history by append_decoded.
+   *
+   * @param bus is the context of the bus the measurement was received on.
+   * @param index is the ControlBoardsInterface::MeasurementIndex.
+   * @param value is the decoded value.
+   */
+  void append_measurement(BusContext &bus, const int &index,
+                          const double &value) {
+    bus.decoded.measurements[index] = value;
+    bus.decoded_measurements[bus.decoded_measurement_count++] = index;
+    TelemetryRecorder *recorder = recorder_.load(std::memory_order_acquire);
+    if (recorder) {
+      recorder->record_measurement(index, value, bus.frame_timestamp);
+    }
   }
 
   /**
-   * @brief send the controls to the cards.
+   * @brief Add a decoded status to the snapshot being assembled by the loop.
+   * It is appended to its history by append_decoded.
    *
-   * @param controls are the controls to be sent.
+   * @param bus is the context of the bus the status was received on.
+   * @param index is the ControlBoardsInterface::BoardIndex.
+   * @param status is the decoded status.
+   */
+  void append_status(BusContext &bus, const int &index,
+                     const BoardStatus &status) {
+    bus.decoded.status[index] = status;
+    bus.decoded_status = index;
+  }
+
+  /**
+   * @brief Append what the newest frame decoded to the histories, in the
+   * order it was decoded. This wakes up the threads waiting on the time
+   * series, so it is called once the snapshot is published for them to read
+   * the new data from the snapshot.
+   *
+   * @param bus is the context of the bus the frame was received on.
    */
-  void send_newest_controls();
+  void append_decoded(BusContext &bus) {
+    for (size_t i = 0; i < bus.decoded_measurement_count; i++) {
+      const int &index = bus.decoded_measurements[i];
+      if (measurement_[index]) {
+        measurement_[index]->append(bus.decoded.measurements[index]);
+      }
+    }
+    bus.decoded_measurement_count = 0;
+    if (bus.decoded_status >= 0) {
+      status_[bus.decoded_status]->append(
+          bus.decoded.status[bus.decoded_status]);
+      bus.decoded_status = -1;
+    }
+  }
 
   /**
-   * @brief send the latest commands to the cards.
+   * @brief Get the board sending a measurement.
    *
+   * @param index is the ControlBoardsInterface::MeasurementIndex.
+   * @return int the ControlBoardsInterface::BoardIndex.
    */
-  void send_newest_command();
+  static int get_measurement_board(const int &index);
 
   /**
-   * @brief This is the helper function used for spawning the real time
-   * thread.
+   * @brief Get the command enabling the streaming of a measurement. There is
+   * no command for the accelerations alone, they come with SEND_ALL.
    *
-   * @param instance_pointer is the current object in this case.
-   * @return THREAD_FUNCTION_RETURN_TYPE depends on the current OS.
+   * @param index is the ControlBoardsInterface::MeasurementIndex.
+   * @return ControlBoardsCommand::IDs
    */
-  static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
-    ((CanBusControlBoards *)(instance_pointer))->loop();
-    return THREAD_FUNCTION_RETURN_VALUE;
-  }
+  static ControlBoardsCommand::IDs get_stream_command(const int &index);
 
   /**
-   * @brief Is the loop that constently communicate with the network.
+   * @brief Enable the streaming of the subscribed measurements only, see
+   * StreamingConfig.
+   */
+  void send_stream_commands();
+
+  /**
+   * @brief Does a received frame carry a subscribed measurement? The status
+   * frames are always received.
+   *
+   * @param can_id
+   * @return bool
+   */
+  bool is_frame_subscribed(const can_id_t &can_id) const;
+
+  /**
+   * @brief Send a frame on one of the buses.
+   *
+   * @param can_frame is the frame to be sent.
+   * @param bus_index is the index of the bus in buses_.
+   */
+  void send_frame(const CanBusFrame &can_frame, const size_t &bus_index);
+
+  /**
+   * @brief Send a frame on all the buses.
+   *
+   * @param can_frame is the frame to be sent.
    */
-  void loop();
+  void broadcast_frame(const CanBusFrame &can_frame);
+
+  /**
+   * @brief Restrict the frames received from the bus to the ones sent by the
+   * active boards.
+   */
+  void update_receive_filter();
 
   /**
    * @brief Display details of this object.
@@ -714,9 +1160,102 @@ private:
 
 private:
   /**
-   * @brief This is the pointer to the can bus to communicate with.
+   * @brief BusContext holds what is owned by the decoding thread of a bus.
+   */
+  struct BusContext {
+    /**
+     * @brief The can bus to communicate with.
+     */
+    std::shared_ptr<CanBusInterface> can_bus;
+
+    /**
+     * @brief This is the snapshot being assembled by the loop. Only accessed
+     * from the loop thread of this bus.
+     */
+    BoardsSnapshot decoded;
+
+    /**
+     * @brief Timestamp of the frame being decoded by the loop.
+     */
+    nanosecs_abs_t frame_timestamp;
+
+    /**
+     * @brief The MeasurementIndex decoded from the frame being decoded, they
+     * are appended to their history once the snapshot is published.
+     */
+    std::array<int, 2> decoded_measurements;
+    size_t decoded_measurement_count;
+
+    /**
+     * @brief The BoardIndex of the status decoded from the frame being
+     * decoded, -1 if none.
+     */
+    int decoded_status;
+
+    /**
+     * @brief This publishes decoded to the readers once a frame is decoded.
+     */
+    SeqLock<BoardsSnapshot> snapshot;
+
+    /**
+     * @brief This is the mutex door serializing the frames handed over to the
+     * can bus.
+     */
+    std::mutex send_door;
+
+    /**
+     * @brief This is the thread decoding the frames of this bus.
+     */
+    real_time_tools::RealTimeThread thread;
+
+    /**
+     * @brief The boards owning this bus.
+     */
+    CanBusControlBoards *boards;
+
+    /**
+     * @brief The index of this bus in buses_.
+     */
+    size_t index;
+  };
+
+  /**
+   * @brief These are the buses to communicate with.
+   */
+  Vector<std::unique_ptr<BusContext>> buses_;
+
+  /**
+   * @brief This is the index in buses_ of the bus of each BoardIndex.
+   */
+  std::array<int, board_count> board_buses_;
+
+  /**
+   * @brief This is the recorder the traffic is handed to, may be null.
    */
-  std::shared_ptr<CanBusInterface> can_bus_;
+  std::atomic<TelemetryRecorder *> recorder_;
+
+  /**
+   * @brief Counters of the decoded frames, see BoardsStats.
+   */
+  std::atomic<uint64_t> decoded_frames_;
+  std::atomic<uint64_t> unknown_frames_;
+  std::atomic<uint64_t> invalid_frames_;
+
+  /**
+   * @brief Time of the newest set_control (ns).
+   */
+  std::atomic<uint64_t> control_time_ns_;
+
+  /**
+   * @brief Latency of the decoding and of the controls, see BoardsStats.
+   */
+  LatencyHistogram decode_latency_;
+  LatencyHistogram control_latency_;
+
+  /**
+   * @brief This keeps the recorder alive as long as the boards.
+   */
+  Ptr<TelemetryRecorder> recorder_owner_;
 
   /**
    * @brief These are the frame IDs that define the kind of data we acquiere
@@ -749,6 +1288,59 @@ private:
     BOARD2_ACC = 0x71,
     BOARD3_ACC = 0x72,
   };
+
+  /**
+   * @brief Layout of the payload of a received frame.
+   */
+  enum class FrameLayout : uint8_t {
+    //! The frame is not handled by the boards.
+    ignored = 0,
+    //! Two Q24 values in bytes [0-3] and [4-7].
+    q24_pair,
+    //! One Q24 value in bytes [0-3].
+    q24_single,
+    //! One Q24 value in bytes [0-3] and the motor index in byte 4.
+    encoder_index,
+    //! Status bitfield of the motor board in byte 0.
+    motor_board_status,
+    //! Status of an encoder board, which only tells the board is alive.
+    encoder_board_status,
+  };
+
+  /**
+   * @brief Describes how the loop decodes the frames of one CAN id.
+   */
+  struct FrameDecoder {
+    //! Layout of the payload.
+    FrameLayout layout;
+    //! MeasurementIndex of each value, or the BoardIndex of a status frame.
+    int target[2];
+    //! Scale from the raw Q24 integer to the unit of the measurement.
+    double scale;
+  };
+
+  /**
+   * @brief Number of CAN ids covered by the decoder table. All the frames we
+   * receive have an id below this.
+   */
+  static constexpr size_t frame_decoder_count = 0x80;
+
+  /**
+   * @brief A useful shortcut
+   */
+  typedef std::array<FrameDecoder, frame_decoder_count> FrameDecoderTable;
+
+  /**
+   * @brief Build the decoder table at compile time.
+   *
+   * @return FrameDecoderTable the decoder of each CAN id.
+   */
+  static constexpr FrameDecoderTable make_frame_decoders();
+
+  /**
+   * @brief The decoder of each CAN id used by the loop.
+   */
+  static const FrameDecoderTable frame_decoders_;
   /**
    * State Info
    */
@@ -764,6 +1356,11 @@ private:
    */
   Vector<Ptr<ScalarTimeseries>> measurement_;
 
+  /**
+   * @brief The subscribed measurements.
+   */
+  const StreamingConfig streaming_;
+
   /**
    * @brief This is the status history of the CAN board.
    */
@@ -820,7 +1417,7 @@ private:
    * now being held constant at 0 control magnitude. This is maintained until
    * reset.
    */
-  bool is_safemode_;
+  std::atomic<bool> is_safemode_;
 
   /**
    * @brief If no control is sent for more than control_timeout_ms_ the board
@@ -828,252 +1425,7 @@ private:
    */
   int control_timeout_ms_;
 
-  /**
-   * @brief This is the thread object that allow to spwan a real-time thread
-   * or not dependening on the current OS.
-   */
-  real_time_tools::RealTimeThread rt_thread_;
 };
 
 //==============================================================================
-/**
- * @brief This class DummyControlBoards implements a ControlBoardsInterface
- * specific to CAN networks.
- */
-class DummyControlBoards : public ControlBoardsInterface {
-public:
-  /**
-   * @brief Construct a new DummyControlBoards object
-   *
-   */
-  DummyControlBoards() {
-    int history_length = 1000;
-
-    measurement_ = create_vector_of_pointers<ScalarTimeseries>(
-        measurement_count, history_length);
-
-    status_ = create_vector_of_pointers<StatusTimeseries>(board_count,
-                                                          history_length);
-
-    control_ = create_vector_of_pointers<ScalarTimeseries>(control_count,
-                                                           history_length);
-
-    sent_control_ = create_vector_of_pointers<ScalarTimeseries>(control_count,
-                                                                history_length);
-
-    BoardStatus status;
-    status.system_enabled = 1;
-    status.motor1_enabled = 1;
-    status.motor1_ready = 1;
-    status.motor2_enabled = 1;
-    status.motor2_ready = 1;
-    status.error_code = 0;
-
-    status_[encoder_board1]->append(status);
-    status_[encoder_board2]->append(status);
-    status_[motor_board]->append(status);
-
-    // Meassurements
-    measurement_[current_0]->append(0);
-    measurement_[current_1]->append(0);
-    measurement_[position_0]->append(0);
-    measurement_[position_1]->append(0);
-    measurement_[position_2]->append(0);
-    measurement_[position_3]->append(0);
-    measurement_[position_4]->append(0);
-    measurement_[velocity_0]->append(0);
-    measurement_[velocity_1]->append(0);
-    measurement_[velocity_2]->append(0);
-    measurement_[velocity_3]->append(0);
-    measurement_[velocity_4]->append(0);
-    measurement_[acceleration_0]->append(0);
-    measurement_[acceleration_1]->append(0);
-    measurement_[acceleration_2]->append(0);
-    measurement_[acceleration_3]->append(0);
-    measurement_[acceleration_4]->append(0);
-    measurement_[analog_0]->append(0);
-    measurement_[analog_1]->append(0);
-    measurement_[encoder_index_0]->append(0);
-    measurement_[encoder_index_1]->append(0);
-
-    sent_control_[current_target_0]->append(0);
-    sent_control_[current_target_1]->append(0);
-
-    control_[current_target_0]->append(0);
-    control_[current_target_1]->append(0);
-  }
-
-  /**
-   * @brief Destroy the DummyControlBoards object
-   */
-  ~DummyControlBoards(){};
-
-  /**
-   * Getters
-   */
-
-  /**
-   * @brief Get the measurement data.
-   *
-   * @param index is the kind of measurement we are insterested in.
-   * @return Ptr<const ScalarTimeseries> is the list of the last measurements
-   * acquiered from the CAN card.
-   */
-  virtual Ptr<const ScalarTimeseries> get_measurement(const int &index) const {
-    return measurement_[index];
-  }
-
-  /**
-   * @brief Get the status of the CAN card.
-   *
-   * @param index the kind of status we are interested in.
-   * @return Ptr<const StatusTimeseries> is the list of last acquiered status.
-   */
-  virtual Ptr<const StatusTimeseries> get_status(const int &index) const {
-    return status_[index];
-  }
-
-  /**
-   * @brief Get the controls to be sent.
-   *
-   * @param index the kind of control we are interested in.
-   * @return Ptr<const ScalarTimeseries> is the list of the control to be
-   * sent.
-   */
-  virtual Ptr<const ScalarTimeseries> get_control(const int &index) const {
-    return control_[index];
-  }
-
-  /**
-   * @brief Get the commands to be sent.
-   *
-   * @return Ptr<const CommandTimeseries> is the list of the command to be
-   * sent.
-   */
-  virtual Ptr<const CommandTimeseries> get_command() const {
-    rt_printf("get_sent_command not implemented in dummy board class.");
-    exit(-1);
-  }
-
-  /**
-   * @brief Get the already sent controls.
-   *
-   * @param index the kind of control we are interested in.
-   * @return Ptr<const ScalarTimeseries> is the list of the sent cotnrols.
-   */
-  virtual Ptr<const ScalarTimeseries> get_sent_control(const int &index) const {
-    return control_[index];
-  }
-
-  /**
-   * @brief Get the already sent commands.
-   *
-   * @return Ptr<const CommandTimeseries> is the list of the sent cotnrols.
-   */
-  virtual Ptr<const CommandTimeseries> get_sent_command() const {
-    rt_printf("get_sent_command not implemented in dummy board class.");
-    exit(-1);
-  }
-
-  /**
-   * Setters
-   */
-
-  /**
-   * @brief Set a board to an active state if it is not already active. This
-   * means the board will now have its status checked for is_ready and if the
-   * board is the motor_board we must send enable the motors etc.
-   *
-   * @param index
-   */
-  virtual void set_active_board(const int &index) {
-    rt_printf("set board index '%d' id to active\n", index);
-  }
-
-  /**
-   * @brief Set the controls, see ControlBoardsInterface::set_control
-   *
-   * @param control
-   * @param index
-   */
-  virtual void set_control(const double &control, const int &index) {
-    control_[index]->append(control);
-  }
-
-  /**
-   * @brief Set the commands, see ControlBoardsInterface::set_command
-   *
-   * @param command
-   */
-  virtual void set_command(const ControlBoardsCommand &command) {
-    rt_printf("set command id: %d\n", command.id_);
-  }
-
-  /**
-   * @brief Send the actual command and controls.
-   */
-  virtual void send_if_input_changed() {
-    for (size_t i = 0; i < control_.size(); i++) {
-      if (control_[i]->length() == 0) {
-        rt_printf("you tried to send control but no control has been set\n");
-        exit(-1);
-      }
-
-      Index timeindex = control_[i]->newest_timeindex();
-      sent_control_[i]->append((*control_[i])[timeindex]);
-    }
-  }
-
-  /**
-   * @brief returns only once board and motors are ready.
-   */
-  virtual void wait_until_ready(){};
-
-  /**
-   * This will cause the control to reset the "safemode" if the control is
-   * currently in safemode. Additionally the system will be set to idle with no
-   * timeout on communication.
-   */
-  virtual void reset() { is_safemode_ = false; };
-
-  /**
-   * This will cause the control to be forced into a "safemode" where the
-   * control is set to zero then held constant until reset.
-   */
-  virtual void enter_safemode() { is_safemode_ = true; };
-
-  /**
-   * This will return if the control is in "safemode".
-   */
-  virtual bool is_safemode() { return is_safemode_; };
-
-  /**
-   * @brief measurement_ contains all the measurements acquiered from the CAN
-   * board.
-   */
-  Vector<Ptr<ScalarTimeseries>> measurement_;
-
-  /**
-   * @brief This is the status history of the CAN board.
-   */
-  Vector<Ptr<StatusTimeseries>> status_;
-
-  /**
-   * @brief This is the buffer of the controls to be sent to card.
-   */
-  Vector<Ptr<ScalarTimeseries>> control_;
-
-  /**
-   * @brief This is the history of the already sent controls.
-   */
-  Vector<Ptr<ScalarTimeseries>> sent_control_;
-
-  /**
-   * @brief Is the system in safemode? This implies the motors were killed and
-   * now being held constant at 0 control magnitude. This is maintained until
-   * reset.
-   */
-  bool is_safemode_ = false;
-};
-
 } // namespace monopod_drivers
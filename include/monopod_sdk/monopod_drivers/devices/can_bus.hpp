@@ -1,7 +1,12 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <real_time_tools/iostream.hpp>
 #include <real_time_tools/spinner.hpp>
@@ -13,6 +18,9 @@
 
 #include "monopod_sdk/monopod_drivers/devices/device_interface.hpp"
 #include "monopod_sdk/monopod_drivers/utils/os_interface.hpp"
+#include "monopod_sdk/monopod_drivers/utils/ring_buffer.hpp"
+#include "monopod_sdk/monopod_drivers/utils/stats.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
 
 namespace monopod_drivers {
 /**
@@ -33,6 +41,18 @@ public:
    * @brief id is the id number return by the CAN bus.
    */
   can_id_t id;
+  /**
+   * @brief timestamp is the time (ns) at which the frame was received, taken
+   * by the kernel on the wall clock (see get_wall_time_ns). It is 0 if no
+   * timestamp is available or for the frames to be sent.
+   */
+  nanosecs_abs_t timestamp = 0;
+  /**
+   * @brief hardware_timestamp is the time (ns) at which the frame was
+   * received, taken by the CAN device on its own clock. It is 0 if the device
+   * does not timestamp the frames.
+   */
+  nanosecs_abs_t hardware_timestamp = 0;
 
   void print() const {
     rt_printf("---------------------------\n");
@@ -46,6 +66,11 @@ public:
 
     rt_printf("dlc: %d\n", dlc);
 
+    rt_printf("timestamp: %llu\n", (unsigned long long)timestamp);
+
+    rt_printf("hardware timestamp: %llu\n",
+              (unsigned long long)hardware_timestamp);
+
     rt_printf("---------------------------\n");
   }
 };
@@ -66,6 +91,86 @@ public:
   int socket;
 };
 
+/**
+ * @brief CanBusStats reports the traffic on a CAN bus and the time spent on
+ * it by the frames.
+ */
+struct CanBusStats {
+  /**
+   * @brief Number of frames received.
+   */
+  uint64_t received_frames = 0;
+
+  /**
+   * @brief Number of frames sent.
+   */
+  uint64_t sent_frames = 0;
+
+  /**
+   * @brief Number of failed attempts to send a frame, the frames are sent
+   * again until the network accepts them.
+   */
+  uint64_t send_retries = 0;
+
+  /**
+   * @brief Number of frames dropped by the kernel because the receive queue
+   * of the socket was full, 0 if the kernel does not report it.
+   */
+  uint64_t dropped_frames = 0;
+
+  /**
+   * @brief Time between the timestamp of a frame by the kernel or the device
+   * and its queuing in the output frames. Only meaningful if the frames are
+   * timestamped on the wall clock, which is not the case on xenomai.
+   */
+  LatencySummary receive;
+
+  /**
+   * @brief Number of frames superseded by a newer frame with the same id
+   * before being sent, see CanBusInterface::set_transmit_coalescing.
+   */
+  uint64_t coalesced_frames = 0;
+
+  /**
+   * @brief Number of times a command could not be queued because the queue
+   * was full, the command is then left pending in the input frames.
+   */
+  uint64_t rejected_frames = 0;
+
+  /**
+   * @brief Time spent handing a frame to the network, retries included.
+   */
+  LatencySummary send;
+};
+
+/**
+ * @brief CanBusTransmitConfig defines how a CanBus sends its frames.
+ */
+struct CanBusTransmitConfig {
+  /**
+   * @brief If true the frames are queued and sent by a dedicated real-time
+   * thread, such that the threads setting them never wait for the network.
+   * Otherwise they are sent by the thread calling send_if_input_changed.
+   */
+  bool asynchronous = true;
+
+  /**
+   * @brief Number of frames each of the queues can hold, a power of two.
+   */
+  size_t queue_capacity = 256;
+
+  /**
+   * @brief Bitrate of the bus (bit/s). The queued frames are not sent faster
+   * than the bus can carry them, 0 disables the pacing.
+   */
+  double bitrate = 1e6;
+
+  /**
+   * @brief Scheduling of the sending thread.
+   */
+  ThreadPolicy thread;
+};
+
 /**
  * @brief CanBusInterface is an abstract class that defines an API for the
  * communication via Can bus.
@@ -108,6 +213,13 @@ public:
    */
   virtual std::shared_ptr<const CanframeTimeseries> get_sent_input_frame() = 0;
 
+  /**
+   * @brief Get the statistics of the bus.
+   *
+   * @return CanBusStats
+   */
+  virtual CanBusStats get_stats() const = 0;
+
   /**
    * setters
    */
@@ -119,6 +231,25 @@ public:
    */
   virtual void set_input_frame(const CanBusFrame &input_frame) = 0;
 
+  /**
+   * @brief Only receive the standard data frames with the given ids. The
+   * filtering is done by the kernel such that the other frames, extended and
+   * remote ones included, never reach the receive loop.
+   *
+   * @param can_ids are the ids of the frames to be received.
+   */
+  virtual void set_receive_filter(const std::vector<can_id_t> &can_ids) = 0;
+
+  /**
+   * @brief Only send the newest of the queued frames with the given ids,
+   * typically the control references. Such frames are ranked below the other
+   * ones, e.g. the commands, which are all sent in order.
+   *
+   * @param can_ids are the ids of the frames which can be superseded.
+   */
+  virtual void
+  set_transmit_coalescing(const std::vector<can_id_t> &can_ids) = 0;
+
   /**
    * Sender
    */
@@ -139,9 +270,13 @@ public:
    *
    * @param can_interface_name
    * @param history_length
+   * @param receive_thread is the scheduling of the receive thread.
+   * @param transmit defines how the frames are sent.
    */
   CanBus(const std::string &can_interface_name,
-         const size_t &history_length = 1000);
+         const size_t &history_length = 1000,
+         const ThreadPolicy &receive_thread = ThreadPolicy(),
+         const CanBusTransmitConfig &transmit = CanBusTransmitConfig());
 
   /**
    * @brief Destroy the CanBus object
@@ -179,6 +314,13 @@ public:
     return sent_input_;
   }
 
+  /**
+   * @brief Get the statistics of the bus, see CanBusInterface::get_stats
+   *
+   * @return CanBusStats
+   */
+  virtual CanBusStats get_stats() const;
+
   /**
    * @brief Setters
    */
@@ -192,12 +334,32 @@ public:
     input_->append(input_frame);
   }
 
+  /**
+   * @brief Only receive the frames with the given ids, see
+   * CanBusInterface::set_receive_filter
+   *
+   * @param can_ids
+   */
+  virtual void set_receive_filter(const std::vector<can_id_t> &can_ids);
+
+  /**
+   * @brief Coalesce the queued frames with the given ids, see
+   * CanBusInterface::set_transmit_coalescing
+   *
+   * @param can_ids
+   */
+  virtual void set_transmit_coalescing(const std::vector<can_id_t> &can_ids);
+
   /**
    * @brief Sender
    */
 
   /**
-   * @brief Send the queue of message to the can network
+   * @brief Send the newest input frame to the can network, or queue it if
+   * the sending is asynchronous. A frame which cannot be queued is not
+   * waited for: it stays the untagged newest input frame, such that the
+   * caller can see it through get_input_frame and send it again, and is
+   * counted in CanBusStats::rejected_frames.
    */
   virtual void send_if_input_changed();
 
@@ -214,6 +376,7 @@ private:
    * OS.
    */
   static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
     ((CanBus *)(instance_pointer))->loop();
     return THREAD_FUNCTION_RETURN_VALUE;
   }
@@ -223,6 +386,48 @@ private:
    */
   void loop();
 
+  /**
+   * @brief This function is the wrapper around the sending loop such that it
+   * can be spawned as a real-time thread.
+   *
+   * @param instance_pointer
+   * @return THREAD_FUNCTION_RETURN_TYPE
+   */
+  static THREAD_FUNCTION_RETURN_TYPE transmit_loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((CanBus *)(instance_pointer))->transmit_loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief Send the queued frames, the commands first, until the destruction
+   * of the bus. The queues are flushed before leaving.
+   */
+  void transmit_loop();
+
+  /**
+   * @brief Queue a frame to be sent by the transmit_loop. This never waits
+   * for the network: if the queue of the coalesced frames is full its oldest
+   * frame is dropped, if the queue of the commands is full the frame is
+   * rejected.
+   *
+   * @param frame
+   * @return bool false if the frame was rejected.
+   */
+  bool queue_frame(const CanBusFrame &frame);
+
+  /**
+   * @brief Send a frame no faster than the bitrate of the bus allows.
+   *
+   * @param frame
+   */
+  void transmit_frame(const CanBusFrame &frame);
+
+  /**
+   * @brief Number of standard CAN ids.
+   */
+  static constexpr size_t can_id_count = CAN_SFF_MASK + 1;
+
   /**
    * @brief Send input data
    *
@@ -230,6 +435,12 @@ private:
    */
   void send_frame(const CanBusFrame &unstamped_can_frame);
 
+  /**
+   * @brief Number of frames which can be received by a single call to
+   * receive_frames().
+   */
+  static constexpr size_t receive_batch_size = 16;
+
   /**
    * @brief Get the output frame from the bus
    *
@@ -237,6 +448,16 @@ private:
    */
   CanBusFrame receive_frame();
 
+  /**
+   * @brief Get all the output frames queued on the bus, waiting for at least
+   * one. On posix this drains the socket with a single system call, on
+   * xenomai this receives a single frame.
+   *
+   * @param frames is filled with the received frames.
+   * @return size_t the number of frames received.
+   */
+  size_t receive_frames(std::array<CanBusFrame, receive_batch_size> &frames);
+
   /**
    * @brief Setup and initialize the CanBus object.
    * It connects to the can bus. This method is used once in the constructor.
@@ -274,6 +495,85 @@ private:
    */
   std::shared_ptr<time_series::TimeSeries<CanBusFrame>> output_;
 
+  /**
+   * @brief Counters of the traffic, see CanBusStats.
+   */
+  std::atomic<uint64_t> received_frames_;
+  std::atomic<uint64_t> sent_frames_;
+  std::atomic<uint64_t> send_retries_;
+  std::atomic<uint64_t> dropped_frames_;
+
+  /**
+   * @brief Latency of the reception and of the sending of the frames.
+   */
+  LatencyHistogram receive_latency_;
+  LatencyHistogram send_latency_;
+
+  /**
+   * @brief How the frames are sent.
+   */
+  const CanBusTransmitConfig transmit_;
+
+  /**
+   * @brief Frames to be sent in order, e.g. the commands.
+   */
+  RingBuffer<CanBusFrame> command_queue_;
+
+  /**
+   * @brief Frames of which only the newest per id is sent, e.g. the controls.
+   */
+  RingBuffer<CanBusFrame> control_queue_;
+
+  /**
+   * @brief Is each of the standard ids coalesced? See
+   * set_transmit_coalescing.
+   */
+  std::array<std::atomic<bool>, can_id_count> is_coalesced_;
+
+  /**
+   * @brief Newest control of each coalesced id, only used by the
+   * transmit_loop and preallocated.
+   */
+  std::vector<CanBusFrame> pending_controls_;
+
+  /**
+   * @brief Number of frames in the queues.
+   */
+  std::atomic<int64_t> queued_frames_;
+
+  /**
+   * @brief Number of superseded frames, see CanBusStats.
+   */
+  std::atomic<uint64_t> coalesced_frames_;
+
+  /**
+   * @brief Number of rejected frames, see CanBusStats.
+   */
+  std::atomic<uint64_t> rejected_frames_;
+
+  /**
+   * @brief Earliest time (s) the next frame can be sent at.
+   */
+  double next_transmit_s_;
+
+  /**
+   * @brief The transmit_loop sleeps on this condition when the queues are
+   * empty, the senders only take the mutex if it does.
+   */
+  std::mutex transmit_door_;
+  std::condition_variable transmit_condition_;
+  std::atomic<bool> is_transmit_waiting_;
+
+  /**
+   * @brief This boolean stops the transmit_loop upon destruction.
+   */
+  std::atomic<bool> is_transmit_active_;
+
+  /**
+   * @brief This is the thread sending the queued frames.
+   */
+  real_time_tools::RealTimeThread transmit_thread_;
+
   /**
    * @brief This boolean makes sure that the loop is not active upon
    * destruction of the current object
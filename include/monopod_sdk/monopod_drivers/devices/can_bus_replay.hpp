@@ -0,0 +1,263 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+
+#include <real_time_tools/thread.hpp>
+
+#include "monopod_sdk/common_header.hpp"
+#include "monopod_sdk/monopod_drivers/devices/can_bus.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief CanBusReplay is a CanBusInterface replaying a recorded CAN log
+ * instead of receiving frames from a network, such that the
+ * CanBusControlBoards can be run offline, e.g. to reproduce an incident or to
+ * measure the decoding throughput.
+ *
+ * The frames are queued in the output frames like the CanBus does, stamped
+ * with the time they are replayed at. The sent frames are kept in the input
+ * frames but go nowhere.
+ */
+class CanBusReplay : public CanBusInterface {
+public:
+  /**
+   * @brief Speed at which the frames are replayed without any pause.
+   */
+  static constexpr double as_fast_as_possible = 0.0;
+
+  /**
+   * @brief Construct a new CanBusReplay object. Nothing is replayed before
+   * start() is called, such that the boards are listening to the bus.
+   *
+   * @param frames are the frames to replay, their timestamps (ns) give the
+   * timing of the replay.
+   * @param speed is the playback speed: 1 replays at the original timing, N
+   * N times faster and as_fast_as_possible does not wait between the frames.
+   * @param history_length is the length of the time series. The default
+   * keeps all the frames of the log, such that none is overwritten before
+   * being decoded when replaying as fast as possible.
+   */
+  CanBusReplay(const Vector<CanBusFrame> &frames, const double &speed = 1.0,
+               const size_t &history_length = 0);
+
+  /**
+   * @brief Construct a new CanBusReplay object from a log file, see load().
+   *
+   * @param log_file is a candump log or a telemetry file.
+   * @param speed see above.
+   * @param history_length see above.
+   */
+  CanBusReplay(const std::string &log_file, const double &speed = 1.0,
+               const size_t &history_length = 0);
+
+  /**
+   * @brief Destroy the CanBusReplay object, stops the replay.
+   */
+  virtual ~CanBusReplay();
+
+  /**
+   * @brief Read the received frames from a log file. The format is detected
+   * from the content of the file.
+   *
+   * @param log_file is a candump log or a telemetry file.
+   * @return Vector<CanBusFrame> the frames in the order they were received.
+   * @throw std::runtime_error if the file cannot be read.
+   */
+  static Vector<CanBusFrame> load(const std::string &log_file);
+
+  /**
+   * @brief Read the frames of a log written by `candump -l`, i.e. lines like
+   * "(1436509052.249713) can0 030#0011223344556677".
+   *
+   * @param log_file is the path of the log.
+   * @param interface_name only keeps the frames of this interface, all the
+   * frames are kept if empty.
+   * @return Vector<CanBusFrame>
+   * @throw std::runtime_error if the file cannot be read.
+   */
+  static Vector<CanBusFrame>
+  load_candump(const std::string &log_file,
+               const std::string &interface_name = "");
+
+  /**
+   * @brief Read the received frames of a file written by the
+   * TelemetryRecorder.
+   *
+   * @param log_file is the path of the file.
+   * @param bus only keeps the frames of this bus, all the frames are kept if
+   * negative.
+   * @return Vector<CanBusFrame>
+   * @throw std::runtime_error if the file cannot be read.
+   */
+  static Vector<CanBusFrame> load_telemetry(const std::string &log_file,
+                                            const int &bus = -1);
+
+  /**
+   * @brief Start the replay, does nothing if it already started.
+   */
+  void start();
+
+  /**
+   * @brief Is every frame of the log replayed?
+   */
+  bool is_done() const { return is_done_; }
+
+  /**
+   * Getters
+   */
+
+  /**
+   * @brief Get the replayed frames.
+   *
+   * @return std::shared_ptr<const CanframeTimeseries>
+   */
+  std::shared_ptr<const CanframeTimeseries> get_output_frame() const {
+    return output_;
+  }
+
+  /**
+   * @brief Get the input frame
+   *
+   * @return std::shared_ptr<const CanframeTimeseries>
+   */
+  virtual std::shared_ptr<const CanframeTimeseries> get_input_frame() {
+    return input_;
+  }
+
+  /**
+   * @brief Get the input frame thas has been "sent"
+   *
+   * @return std::shared_ptr<const CanframeTimeseries>
+   */
+  virtual std::shared_ptr<const CanframeTimeseries> get_sent_input_frame() {
+    return sent_input_;
+  }
+
+  /**
+   * @brief Get the statistics of the replay, see CanBusInterface::get_stats
+   *
+   * @return CanBusStats
+   */
+  virtual CanBusStats get_stats() const;
+
+  /**
+   * Setters
+   */
+
+  /**
+   * @brief Set the input frame
+   *
+   * @param input_frame
+   */
+  virtual void set_input_frame(const CanBusFrame &input_frame) {
+    input_->append(input_frame);
+  }
+
+  /**
+   * @brief Only replay the frames with the given ids, like the kernel does
+   * for the CanBus, see CanBusInterface::set_receive_filter
+   *
+   * @param can_ids
+   */
+  virtual void set_receive_filter(const std::vector<can_id_t> &can_ids);
+
+  /**
+   * @brief Nothing is queued, the frames are "sent" one by one.
+   */
+  virtual void
+  set_transmit_coalescing(const std::vector<can_id_t> & /*can_ids*/) {}
+
+  /**
+   * @brief Move the newest input frame to the sent frames.
+   */
+  virtual void send_if_input_changed();
+
+private:
+  /**
+   * @brief this function is just a wrapper around the actual loop function,
+   * such that it can be spawned as a posix thread.
+   */
+  static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((CanBusReplay *)(instance_pointer))->loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief Replay the frames.
+   */
+  void loop();
+
+  /**
+   * @brief Number of standard CAN ids.
+   */
+  static constexpr size_t can_id_count = CAN_SFF_MASK + 1;
+
+  /**
+   * @brief The frames to replay.
+   */
+  const Vector<CanBusFrame> frames_;
+
+  /**
+   * @brief The playback speed.
+   */
+  const double speed_;
+
+  /**
+   * @brief Is each of the standard ids replayed? See set_receive_filter.
+   */
+  std::array<std::atomic<bool>, can_id_count> is_received_;
+
+  /**
+   * @brief Frames to be "sent".
+   */
+  Ptr<CanframeTimeseries> input_;
+
+  /**
+   * @brief Frames already "sent".
+   */
+  Ptr<CanframeTimeseries> sent_input_;
+
+  /**
+   * @brief The replayed frames.
+   */
+  Ptr<CanframeTimeseries> output_;
+
+  /**
+   * @brief Counters of the traffic, see CanBusStats.
+   */
+  std::atomic<uint64_t> received_frames_;
+  std::atomic<uint64_t> sent_frames_;
+
+  /**
+   * @brief Did the replay start?
+   */
+  bool is_started_;
+
+  /**
+   * @brief Is the replay over?
+   */
+  std::atomic<bool> is_done_;
+
+  /**
+   * @brief This boolean makes sure the loop is stopped upon destruction of
+   * this object.
+   */
+  std::atomic<bool> is_loop_active_;
+
+  /**
+   * @brief Is a receive filter set? The extended and remote frames are then
+   * dropped, like the kernel does.
+   */
+  std::atomic<bool> is_filtering_;
+
+  /**
+   * @brief This is the thread replaying the frames.
+   */
+  real_time_tools::RealTimeThread rt_thread_;
+};
+
+} // namespace monopod_drivers
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <string>
 
@@ -47,6 +48,28 @@ public:
   virtual Ptr<const ScalarTimeseries>
   get_measurement(const Measurements &index) const = 0;
 
+  /**
+   * @brief Get the index of a measurement in the ControlBoardsInterface, e.g.
+   * to read it from a BoardsSnapshot.
+   *
+   * @param index is the kind of measurement we are instersted in.
+   * @return int the ControlBoardsInterface::MeasurementIndex.
+   */
+  virtual int get_measurement_index(const Measurements &index) const = 0;
+
+  /**
+   * @brief Get a non-owning handle on the history of a measurement. It is
+   * valid as long as the board and is meant to be resolved once, such that
+   * reading a measurement neither copies a shared pointer nor dispatches on
+   * the joint.
+   *
+   * @param index is the kind of measurement we are instersted in.
+   * @return const ScalarTimeseries* the history, nullptr if this device does
+   * not provide the measurement.
+   */
+  virtual const ScalarTimeseries *
+  get_measurement_channel(const Measurements &index) const = 0;
+
   /**
    * @brief Get the status.
    *
@@ -93,6 +116,27 @@ public:
   virtual Ptr<const ScalarTimeseries>
   get_measurement(const Measurements &index) const;
 
+  /**
+   * @brief Get the index of a measurement in the ControlBoardsInterface, see
+   * EncoderInterface for more information.
+   *
+   * @param index is the kind of measurement we are instersted in.
+   * @return int the ControlBoardsInterface::MeasurementIndex.
+   */
+  virtual int get_measurement_index(const Measurements &index) const;
+
+  /**
+   * @brief Get a non-owning handle on the history of a measurement, see
+   * EncoderInterface for more information.
+   *
+   * @param index is the kind of measurement we are instersted in.
+   * @return const ScalarTimeseries* the history, nullptr if not provided.
+   */
+  virtual const ScalarTimeseries *
+  get_measurement_channel(const Measurements &index) const {
+    return index < measurement_count ? measurement_channels_[index] : nullptr;
+  }
+
   /**
    * @brief Get the status.
    *
@@ -105,6 +149,29 @@ public:
   virtual void print() const;
 
 protected:
+  /**
+   * @brief Find the index of a measurement of an encoder in the
+   * ControlBoardsInterface.
+   *
+   * @param encoder_id is the joint of the encoder.
+   * @param index is the kind of measurement.
+   * @return int the ControlBoardsInterface::MeasurementIndex, -1 if the
+   * encoder does not provide the measurement.
+   */
+  static int find_measurement_index(const JointNamesIndex &encoder_id,
+                                    const Measurements &index);
+
+  /**
+   * @brief Map a measurement of this device to the boards and resolve its
+   * history.
+   *
+   * @param index is the kind of measurement.
+   * @param measurement_index is the ControlBoardsInterface::MeasurementIndex,
+   * -1 if not provided.
+   */
+  void set_measurement_channel(const Measurements &index,
+                               const int &measurement_index);
+
   /**
    * @brief This sets the board that relates to the specified encoder_id to be
    * active in the CanBusControlBoards
@@ -120,6 +187,23 @@ protected:
    * @brief The id of the motor on the EncoderBoard.
    */
   JointNamesIndex encoder_id_;
+
+  /**
+   * @brief The board sending the measurements of this encoder.
+   */
+  BoardIndex board_index_;
+
+  /**
+   * @brief The ControlBoardsInterface::MeasurementIndex of each Measurements,
+   * -1 if not provided.
+   */
+  std::array<int, measurement_count> measurement_indices_;
+
+  /**
+   * @brief The history of each Measurements, owned by board_.
+   */
+  std::array<const ScalarTimeseries *, measurement_count>
+      measurement_channels_;
 };
 
 } // namespace monopod_drivers
@@ -107,7 +107,32 @@ public:
    * measurement history.
    */
   virtual Ptr<const ScalarTimeseries>
-  get_measurement(const Measurements &index) const;
+  get_measurement(const Measurements &index) const {
+    return Encoder::get_measurement(index);
+  }
+
+  /**
+   * @brief Get the index of a measurement in the ControlBoardsInterface, see
+   * EncoderInterface for more information.
+   *
+   * @param index
+   * @return int the ControlBoardsInterface::MeasurementIndex.
+   */
+  virtual int get_measurement_index(const Measurements &index) const {
+    return Encoder::get_measurement_index(index);
+  }
+
+  /**
+   * @brief Get a non-owning handle on the history of a measurement, see
+   * EncoderInterface for more information.
+   *
+   * @param index
+   * @return const ScalarTimeseries* the history, nullptr if not provided.
+   */
+  virtual const ScalarTimeseries *
+  get_measurement_channel(const Measurements &index) const {
+    return Encoder::get_measurement_channel(index);
+  }
 
   /**
    * @brief Get the status.
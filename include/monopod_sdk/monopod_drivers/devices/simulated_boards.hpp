@@ -0,0 +1,428 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include <real_time_tools/thread.hpp>
+
+#include "monopod_sdk/monopod_drivers/devices/boards.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief SimulationParameters defines the model integrated by the
+ * SimulatedControlBoards. The joint arrays are ordered as the measurements of
+ * the boards: hip, knee, planarizer pitch, planarizer yaw and boom connector,
+ * i.e. position_0 to position_4.
+ */
+struct SimulationParameters {
+  /**
+   * @brief Integration step (s). The simulated boards publish one set of
+   * measurements per step, the real boards send theirs every 1 ms.
+   */
+  double time_step = 0.001;
+
+  /**
+   * @brief If true the simulation is stepped in real time by its own thread.
+   * Otherwise it runs in lockstep with the controller: every call to
+   * send_if_input_changed advances it by one step, as fast as the controller
+   * goes.
+   */
+  bool real_time = true;
+
+  /**
+   * @brief Torque constant of the leg motors (Nm/A), the one Monopod gives
+   * its MotorJointModule by default.
+   */
+  double motor_constant = LEG_MOTOR_CONSTANT;
+
+  /**
+   * @brief Gear ratio between the leg motors and the joints, the one Monopod
+   * gives its MotorJointModule by default.
+   */
+  double gear_ratio = LEG_GEAR_RATIO;
+
+  /**
+   * @brief Inertia of each joint, the rotor inertia is included (kg.m^2).
+   */
+  std::array<double, NUMBER_JOINTS> inertia = {{0.02, 0.01, 0.5, 1.0, 0.01}};
+
+  /**
+   * @brief Viscous friction of each joint (N.m.s/rad).
+   */
+  std::array<double, NUMBER_JOINTS> damping = {{0.05, 0.05, 0.1, 0.1, 0.01}};
+
+  /**
+   * @brief Mass (kg) and length (m) of the thigh and of the shank, the leg
+   * hangs from the planarizer when all the joints are at zero.
+   */
+  double thigh_mass = 0.5;
+  double thigh_length = 0.16;
+  double shank_mass = 0.3;
+  double shank_length = 0.16;
+
+  /**
+   * @brief Gravity (m/s^2).
+   */
+  double gravity = 9.81;
+};
+
+/**
+ * @brief SimulationStateView points to the state of several simulated robots
+ * stored as structures of arrays: the value of the model joint j of the robot
+ * i is at [j][i], the joints in the order of SimulationParameters.
+ */
+struct SimulationStateView {
+  /**
+   * @brief Joint side state (rad, rad/s, rad/s^2).
+   */
+  std::array<double *, NUMBER_JOINTS> position;
+  std::array<double *, NUMBER_JOINTS> velocity;
+  std::array<double *, NUMBER_JOINTS> acceleration;
+
+  /**
+   * @brief Currents applied to the hip and knee motors (A).
+   */
+  std::array<const double *, NUMBER_LEG_JOINTS> current;
+};
+
+/**
+ * @brief This class SimulatedControlBoards implements a ControlBoardsInterface
+ * backed by a simple model of the monopod instead of a CAN network.
+ *
+ * The current targets are converted to joint torques using the motor constant
+ * and the gear ratio, the leg is integrated as two pendulums hanging from the
+ * planarizer and the planarizer pitch receives the reaction of the hip. The
+ * measurements are published exactly as the CanBusControlBoards do, at the
+ * rate of the real boards, so the rest of the sdk runs unchanged on top.
+ */
+class SimulatedControlBoards : public ControlBoardsInterface {
+public:
+  /**
+   * @brief Construct a new SimulatedControlBoards object
+   *
+   * @param parameters of the simulated model.
+   * @param history is the length of the time series, see HistoryConfig.
+   * @param thread is the scheduling of the simulation thread, only spawned
+   * in real time.
+   */
+  SimulatedControlBoards(
+      const SimulationParameters &parameters = SimulationParameters(),
+      const HistoryConfig &history = HistoryConfig(),
+      const ThreadPolicy &thread = ThreadPolicy());
+
+  /**
+   * @brief Destroy the SimulatedControlBoards object
+   */
+  ~SimulatedControlBoards();
+
+  /**
+   * Getters
+   */
+
+  /**
+   * @brief Get the measurement data.
+   *
+   * @param index is the kind of measurement we are insterested in.
+   * @return Ptr<const ScalarTimeseries> is the list of the last simulated
+   * measurements.
+   */
+  virtual Ptr<const ScalarTimeseries> get_measurement(const int &index) const {
+    return measurement_[index];
+  }
+
+  /**
+   * @brief Get the status of the boards.
+   *
+   * @param index the kind of status we are interested in.
+   * @return Ptr<const StatusTimeseries> is the list of last status.
+   */
+  virtual Ptr<const StatusTimeseries> get_status(const int &index) const {
+    return status_[index];
+  }
+
+  /**
+   * @brief Get the controls to be sent.
+   *
+   * @param index the kind of control we are interested in.
+   * @return Ptr<const ScalarTimeseries> is the list of the control to be
+   * sent.
+   */
+  virtual Ptr<const ScalarTimeseries> get_control(const int &index) const {
+    return control_[index];
+  }
+
+  /**
+   * @brief Get the commands to be sent.
+   *
+   * @return Ptr<const CommandTimeseries> is the list of the command to be
+   * sent.
+   */
+  virtual Ptr<const CommandTimeseries> get_command() const { return command_; }
+
+  /**
+   * @brief Get the already sent controls.
+   *
+   * @param index the kind of control we are interested in.
+   * @return Ptr<const ScalarTimeseries> is the list of the sent cotnrols.
+   */
+  virtual Ptr<const ScalarTimeseries> get_sent_control(const int &index) const {
+    return sent_control_[index];
+  }
+
+  /**
+   * @brief Get the already sent commands.
+   *
+   * @return Ptr<const CommandTimeseries> is the list of the sent commands.
+   */
+  virtual Ptr<const CommandTimeseries> get_sent_command() const {
+    return sent_command_;
+  }
+
+  /**
+   * @brief Get the newest simulated snapshot, see
+   * ControlBoardsInterface::get_snapshot
+   *
+   * @param snapshot
+   */
+  virtual void get_snapshot(BoardsSnapshot &snapshot) const {
+    snapshot_.load(snapshot);
+  }
+
+  /**
+   * @brief Get the statistics of the simulated boards, every step is counted
+   * as one decoded frame.
+   *
+   * @return BoardsStats
+   */
+  virtual BoardsStats get_stats() const;
+
+  /**
+   * @brief Get the simulated time (s).
+   *
+   * @return double
+   */
+  double get_time() const;
+
+  /**
+   * Setters
+   */
+
+  /**
+   * @brief All the simulated boards are always active.
+   */
+  virtual void set_active_board(const int & /*index*/) {}
+
+  /**
+   * @brief Set the recorder, see ControlBoardsInterface::set_recorder. The
+   * simulated measurements are recorded, there are no frames.
+   *
+   * @param recorder
+   */
+  virtual void set_recorder(Ptr<TelemetryRecorder> recorder);
+
+  /**
+   * @brief Set the controls, see ControlBoardsInterface::set_control
+   *
+   * @param control
+   * @param index
+   */
+  virtual void set_control(const double &control, const int &index) {
+    control_[index]->append(control);
+  }
+
+  /**
+   * @brief Set the commands, see ControlBoardsInterface::set_command
+   *
+   * @param command
+   */
+  virtual void set_command(const ControlBoardsCommand &command) {
+    command_->append(command);
+  }
+
+  /**
+   * @brief Apply the new controls and commands to the model. In lockstep mode
+   * this also advances the simulation by one step.
+   */
+  virtual void send_if_input_changed();
+
+  /**
+   * @brief The simulated boards are ready as soon as they are constructed.
+   */
+  virtual void
+  wait_until_ready(const ReadinessConfig & /*config*/ = ReadinessConfig()) {}
+
+  /**
+   * @brief Leave the safemode.
+   */
+  virtual void reset() { is_safemode_ = false; }
+
+  /**
+   * @brief Enter the safemode: the motors receive no current until reset.
+   */
+  virtual void enter_safemode() { is_safemode_ = true; }
+
+  /**
+   * @brief Is the control in safemode?
+   */
+  virtual bool is_safemode() { return is_safemode_; }
+
+  /**
+   * @brief Advance the simulation and publish the measurements of each step.
+   *
+   * @param step_count is the number of steps.
+   */
+  void step(const size_t &step_count = 1);
+
+  /**
+   * @brief Set the state of a joint, e.g. to start a rollout from a given
+   * configuration. The measurements are published right away.
+   *
+   * @param joint_index is the JointNamesIndex.
+   * @param position (rad) at the joint.
+   * @param velocity (rad/s) at the joint.
+   */
+  void set_joint_state(const int &joint_index, const double &position,
+                       const double &velocity = 0.0);
+
+  /**
+   * @brief Integrate the model of the robots [begin, end) over one time step.
+   * The robots are independent, so disjoint ranges can be integrated
+   * concurrently.
+   *
+   * @param parameters of the simulated model.
+   * @param state of all the robots.
+   * @param begin is the first robot.
+   * @param end is one past the last robot.
+   */
+  static void integrate_model(const SimulationParameters &parameters,
+                              const SimulationStateView &state,
+                              const size_t &begin, const size_t &end);
+
+  /**
+   * @brief Get the offset of a joint in the model arrays.
+   *
+   * @param joint_index is the JointNamesIndex.
+   * @return int the offset from position_0.
+   */
+  static int get_model_index(const int &joint_index);
+
+private:
+  /**
+   * @brief this function is just a wrapper around the actual loop function,
+   * such that it can be spawned as a posix thread.
+   */
+  static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((SimulatedControlBoards *)(instance_pointer))->loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief Step the simulation in real time.
+   */
+  void loop();
+
+  /**
+   * @brief Integrate the model over one time step.
+   */
+  void integrate();
+
+  /**
+   * @brief Publish the state of the model as measurements.
+   */
+  void publish();
+
+  /**
+   * @brief The simulated model.
+   */
+  const SimulationParameters parameters_;
+
+  /**
+   * @brief Joint side state of the model (rad, rad/s, rad/s^2), in the order
+   * of the measurements.
+   */
+  std::array<double, NUMBER_JOINTS> position_;
+  std::array<double, NUMBER_JOINTS> velocity_;
+  std::array<double, NUMBER_JOINTS> acceleration_;
+
+  /**
+   * @brief The currents applied to the motors (A).
+   */
+  std::array<double, control_count> current_;
+
+  /**
+   * @brief Number of steps integrated so far.
+   */
+  uint64_t step_count_;
+
+  /**
+   * @brief The mutex door serializing the access to the model.
+   */
+  mutable std::mutex model_door_;
+
+  /**
+   * @brief measurement_ contains all the simulated measurements.
+   */
+  Vector<Ptr<ScalarTimeseries>> measurement_;
+
+  /**
+   * @brief This is the status history of the boards.
+   */
+  Vector<Ptr<StatusTimeseries>> status_;
+
+  /**
+   * @brief This is the buffer of the controls to be sent to the model.
+   */
+  Vector<Ptr<ScalarTimeseries>> control_;
+
+  /**
+   * @brief This is the buffer of the commands to be sent to the model.
+   */
+  Ptr<CommandTimeseries> command_;
+
+  /**
+   * @brief This is the history of the controls applied to the model.
+   */
+  Vector<Ptr<ScalarTimeseries>> sent_control_;
+
+  /**
+   * @brief This is the history of the commands applied to the model.
+   */
+  Ptr<CommandTimeseries> sent_command_;
+
+  /**
+   * @brief This is the snapshot being assembled by publish.
+   */
+  BoardsSnapshot decoded_;
+
+  /**
+   * @brief This publishes the newest decoded_ to the readers.
+   */
+  SeqLock<BoardsSnapshot> snapshot_;
+
+  /**
+   * @brief This is the recorder the measurements are handed to, may be null.
+   */
+  Ptr<TelemetryRecorder> recorder_;
+
+  /**
+   * @brief Is the system in safemode? The motors receive no current until
+   * reset.
+   */
+  std::atomic<bool> is_safemode_;
+
+  /**
+   * @brief This boolean makes sure the real time loop is stopped upon
+   * destruction of this object.
+   */
+  std::atomic<bool> is_loop_active_;
+
+  /**
+   * @brief This is the thread stepping the simulation in real time.
+   */
+  real_time_tools::RealTimeThread rt_thread_;
+};
+
+} // namespace monopod_drivers
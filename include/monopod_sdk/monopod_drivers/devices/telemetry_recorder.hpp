@@ -0,0 +1,243 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <real_time_tools/thread.hpp>
+
+#include "monopod_sdk/monopod_drivers/devices/can_bus.hpp"
+#include "monopod_sdk/monopod_drivers/utils/ring_buffer.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief TelemetryRecord is one 32 bytes entry of a telemetry file. A file is
+ * a TelemetryFileHeader followed by an array of TelemetryRecord, such that it
+ * can be memory mapped and read as is.
+ */
+struct TelemetryRecord {
+  /**
+   * @brief Kind of the entry.
+   */
+  enum Kind : uint8_t {
+    //! A frame received from a CAN bus, channel is the bus.
+    RECEIVED_FRAME = 0,
+    //! A frame sent to a CAN bus, channel is the bus.
+    SENT_FRAME,
+    //! A decoded measurement, channel is the
+    //! ControlBoardsInterface::MeasurementIndex and data holds the double.
+    MEASUREMENT,
+  };
+
+  /**
+   * @brief Time (ns) at which the entry was recorded, steady clock.
+   */
+  uint64_t host_time_ns;
+
+  /**
+   * @brief Timestamp (ns) of the frame given by the CAN device, 0 if none.
+   */
+  uint64_t timestamp_ns;
+
+  /**
+   * @brief Id of the CAN frame.
+   */
+  uint32_t can_id;
+
+  /**
+   * @brief Bus or measurement index, see Kind.
+   */
+  uint16_t channel;
+
+  /**
+   * @brief One of Kind.
+   */
+  uint8_t kind;
+
+  /**
+   * @brief Size of the data of the CAN frame.
+   */
+  uint8_t dlc;
+
+  /**
+   * @brief Payload of the CAN frame or the value of the measurement.
+   */
+  uint8_t data[8];
+};
+static_assert(sizeof(TelemetryRecord) == 32,
+              "The telemetry file format requires 32 bytes records.");
+
+/**
+ * @brief TelemetryFileHeader is the first 32 bytes of a telemetry file.
+ */
+struct TelemetryFileHeader {
+  /**
+   * @brief Identifies the file as a telemetry file.
+   */
+  char magic[8] = {'M', 'P', 'O', 'D', 'T', 'L', 'M', '\0'};
+
+  /**
+   * @brief Version of the file format.
+   */
+  uint32_t version = 1;
+
+  /**
+   * @brief Size of a TelemetryRecord.
+   */
+  uint32_t record_size = sizeof(TelemetryRecord);
+
+  /**
+   * @brief Padding to keep the records aligned.
+   */
+  uint8_t reserved[16] = {};
+};
+static_assert(sizeof(TelemetryFileHeader) == 32,
+              "The telemetry file header must be 32 bytes.");
+
+/**
+ * @brief TelemetryRecorder records the CAN traffic and the decoded
+ * measurements to a binary file without disturbing the real-time threads.
+ *
+ * The real-time threads push fixed size records in a preallocated lock-free
+ * ring buffer, which never allocates nor blocks. A low priority thread drains
+ * the buffer into the file. Records are dropped, and counted, if the writer
+ * does not keep up.
+ */
+class TelemetryRecorder {
+public:
+  /**
+   * @brief Construct a new TelemetryRecorder object.
+   *
+   * @param capacity is the number of records buffered, a power of two.
+   * @param thread is the policy of the writer thread, which must never
+   * preempt the threads talking to the boards.
+   */
+  TelemetryRecorder(
+      const size_t &capacity = 1 << 16,
+      const ThreadPolicy &thread = ThreadPolicy::with_priority(5));
+
+  /**
+   * @brief Destroy the TelemetryRecorder object, stops the recording.
+   */
+  ~TelemetryRecorder();
+
+  /**
+   * @brief Start recording to a file.
+   *
+   * @param file_name is the path of the file, overwritten if it exists.
+   * @return bool false if the file could not be opened or if already
+   * recording.
+   */
+  bool start(const std::string &file_name);
+
+  /**
+   * @brief Stop recording. All the buffered records are written.
+   */
+  void stop();
+
+  /**
+   * @brief Is the recorder recording?
+   */
+  bool is_recording() const {
+    return is_recording_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the number of records dropped since the recording started.
+   *
+   * @return uint64_t
+   */
+  uint64_t get_dropped_records() const {
+    return dropped_records_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Record a CAN frame. Real-time safe.
+   *
+   * @param kind is TelemetryRecord::RECEIVED_FRAME or SENT_FRAME.
+   * @param bus is the index of the bus.
+   * @param frame is the frame.
+   */
+  void record_frame(const TelemetryRecord::Kind &kind, const size_t &bus,
+                    const CanBusFrame &frame);
+
+  /**
+   * @brief Record a decoded measurement. Real-time safe.
+   *
+   * @param index is the ControlBoardsInterface::MeasurementIndex.
+   * @param value is the decoded value.
+   * @param timestamp_ns is the timestamp of the frame it was decoded from.
+   */
+  void record_measurement(const int &index, const double &value,
+                          const uint64_t &timestamp_ns);
+
+private:
+  /**
+   * @brief this function is just a wrapper around the actual loop function,
+   * such that it can be spawned as a posix thread.
+   */
+  static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((TelemetryRecorder *)(instance_pointer))->loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief Write the buffered records to the file until stopped.
+   */
+  void loop();
+
+  /**
+   * @brief Write all the buffered records to the file.
+   *
+   * @return size_t the number of records written.
+   */
+  size_t flush();
+
+  /**
+   * @brief Push a record, dropping it if the buffer is full.
+   *
+   * @param record
+   */
+  void push(TelemetryRecord &record);
+
+  /**
+   * @brief The records waiting to be written.
+   */
+  RingBuffer<TelemetryRecord> records_;
+
+  /**
+   * @brief The file being written.
+   */
+  FILE *file_;
+
+  /**
+   * @brief True while records are accepted.
+   */
+  std::atomic<bool> is_recording_;
+
+  /**
+   * @brief True while the writer thread runs.
+   */
+  std::atomic<bool> is_loop_active_;
+
+  /**
+   * @brief Number of records dropped because the buffer was full.
+   */
+  std::atomic<uint64_t> dropped_records_;
+
+  /**
+   * @brief The writer thread.
+   */
+  real_time_tools::RealTimeThread thread_;
+
+  /**
+   * @brief The policy of the writer thread.
+   */
+  ThreadPolicy thread_policy_;
+};
+
+} // namespace monopod_drivers
@@ -10,6 +10,7 @@
 
 #include "monopod_sdk/common_header.hpp"
 #include "monopod_sdk/monopod_drivers/devices/encoder.hpp"
+#include "monopod_sdk/monopod_drivers/utils/seqlock.hpp"
 
 namespace monopod_drivers {
 
@@ -81,6 +82,43 @@ public:
    */
   virtual double get_measured_index_angle() const;
 
+  /**
+   * @brief Read the joint position, velocity and acceleration from a board
+   * snapshot. The values are NaN as long as they were never received.
+   *
+   * @param snapshot is a snapshot obtained from the ControlBoardsInterface.
+   * @param position (rad).
+   * @param velocity (rad/s).
+   * @param acceleration (rad/s^2).
+   */
+  virtual void read_joint_state(const BoardsSnapshot &snapshot,
+                                double &position, double &velocity,
+                                double &acceleration) const;
+
+  /**
+   * @brief Get the index of a measurement of this joint in the
+   * ControlBoardsInterface.
+   *
+   * @param index is the kind of measurement we are instersted in.
+   * @return int the ControlBoardsInterface::MeasurementIndex, -1 if the
+   * encoder does not provide it.
+   */
+  virtual int get_measurement_index(const Measurements &index) const {
+    return measurement_indices_[index];
+  }
+
+  /**
+   * @brief Get the history of a raw measurement of this joint, e.g. to wait
+   * for new measurements.
+   *
+   * @param index is the kind of measurement we are instersted in.
+   * @return Ptr<const ScalarTimeseries> the measurements of the encoder.
+   */
+  virtual Ptr<const ScalarTimeseries>
+  get_measurement(const Measurements &index) const {
+    return encoder_->get_measurement(index);
+  }
+
   /**
    * @brief Get the zero_angle_. These are the angle between the starting pose
    * and the theoretical zero pose.
@@ -90,10 +128,18 @@ public:
   virtual double get_zero_angle() const;
 
   /**
-   * @brief Set the limit of the provided meassurement index.
+   * @brief Number of limited measurements: position, velocity and
+   * acceleration.
+   */
+  static constexpr size_t limit_count = 3;
+
+  /**
+   * @brief Set the limit of the provided meassurement index. The update is
+   * published at once, it never stalls the threads checking the limits.
    *
    * @param index of the position type to set limit of
    * @param limit is a struct holding the limit for the specified meassurement.
+   * @throw std::invalid_argument if the measurement has no limit.
    */
   virtual void set_limit(const Measurements &index, const JointLimit &limit);
 
@@ -101,12 +147,14 @@ public:
    * @brief Get the limit of the provided meassurement index.
    *
    * @param index of the position type to set limit of
+   * @throw std::invalid_argument if the measurement has no limit.
    */
   virtual JointLimit get_limit(const Measurements &index) const;
 
   /**
    * @brief Check all of the joint limits. True if in range otherwise false.
-   *
+   * The measurements which are not streamed are not checked. This never
+   * locks, so it can be called from a real-time thread.
    */
   virtual bool check_limits() const;
 
@@ -158,10 +206,31 @@ protected:
   std::shared_ptr<monopod_drivers::EncoderInterface> encoder_;
 
   /**
-   * @brief This is the map of the limits for each meassurement.
+   * @brief The history of each Measurements of the encoder, nullptr if not
+   * provided. These are owned by the board kept alive by encoder_.
+   */
+  std::array<const ScalarTimeseries *, measurement_count> channels_;
+
+  /**
+   * @brief The ControlBoardsInterface::MeasurementIndex of each Measurements,
+   * -1 if not provided or not streamed, see StreamingConfig.
+   */
+  std::array<int, measurement_count> measurement_indices_;
+
+  /**
+   * @brief A useful shortcut
+   */
+  typedef std::array<JointLimit, limit_count> JointLimits;
+
+  /**
+   * @brief The limit of each limited meassurement, owned by the writers.
+   */
+  JointLimits limits_;
+
+  /**
+   * @brief Publishes limits_ to the readers.
    */
-  std::unordered_map<Measurements, JointLimit> limits_ = {
-      {position, {}}, {velocity, {}}, {acceleration, {}}};
+  SeqLock<JointLimits> published_limits_;
 
   /**
    * @brief This correspond to the reduction (\f$ \beta \f$) between the encoder
@@ -181,10 +250,10 @@ protected:
   double polarity_;
 
   /**
-   * @brief This is the mutex door for the limits_ varible. Allows threadsafe
-   * limit checking.
+   * @brief This is the mutex door serializing the updates of limits_, the
+   * readers never take it.
    */
-  mutable std::mutex limit_door_;
+  std::mutex limit_door_;
 };
 
 } // namespace monopod_drivers
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <map>
 #include <math.h>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <time_series/time_series.hpp>
@@ -12,11 +17,100 @@
 #include "monopod_sdk/monopod_drivers/devices/motor.hpp"
 #include "monopod_sdk/monopod_drivers/motor_joint_module.hpp"
 #include "monopod_sdk/monopod_drivers/utils/polynome.hpp"
+#include "monopod_sdk/monopod_drivers/utils/ring_buffer.hpp"
+#include "monopod_sdk/monopod_drivers/utils/seqlock.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
 
 #include "monopod_sdk/common_header.hpp"
 
 namespace monopod_drivers {
 
+/**
+ * @brief HomingConfig sets how the leg searches the encoder indexes of its
+ * joints. Both joints are homed at the same time with a trapezoidal speed
+ * profile, then brought back to their zero position.
+ */
+struct HomingConfig {
+  /**
+   * @brief Period (s) of the homing state machine. It runs on new
+   * measurements, so it never runs faster than the boards send them (1 kHz).
+   */
+  double step_period_s = 0.001;
+
+  /**
+   * @brief Cruise speed of the search (rad/s), negative to search in negative
+   * direction.
+   */
+  double search_speed_rad_per_sec = 1.0;
+
+  /**
+   * @brief Acceleration of the search up to the cruise speed (rad/s^2).
+   */
+  double search_acceleration_rad_per_sec2 = 4.0;
+
+  /**
+   * @brief Maximum distance each joint moves while searching its index (rad).
+   */
+  double search_distance_limit_rad = 2 * M_PI;
+
+  /**
+   * @brief Average speed of the minimum jerk motion to the zero position
+   * once the indexes are found (rad/s).
+   */
+  double return_speed_rad_per_sec = 1.0;
+};
+
+/**
+ * @brief HomingPhase is the state of the homing state machine of the leg.
+ */
+enum class HomingPhase {
+  //! No homing was started.
+  IDLE,
+  //! Searching the encoder indexes.
+  SEARCHING,
+  //! Moving from the home position to the zero position.
+  RETURNING,
+  //! Both joints are homed and at zero.
+  SUCCEEDED,
+  //! A joint did not find its index, the board entered safe mode or the
+  //! homing was stopped.
+  FAILED
+};
+
+/**
+ * @brief HomingProgress reports the progress of the homing of the leg, in the
+ * order [hip_joint, knee_joint].
+ */
+struct HomingProgress {
+  /**
+   * @brief Phase of the homing.
+   */
+  HomingPhase phase = HomingPhase::IDLE;
+
+  /**
+   * @brief Status of the search of each joint.
+   */
+  std::array<HomingReturnCode, NUMBER_LEG_JOINTS> joint_status = {
+      {HomingReturnCode::NOT_INITIALIZED, HomingReturnCode::NOT_INITIALIZED}};
+
+  /**
+   * @brief Distance searched by each joint so far (rad).
+   */
+  std::array<double, NUMBER_LEG_JOINTS> search_distance_rad = {{0.0, 0.0}};
+
+  /**
+   * @brief Time since the homing started (s).
+   */
+  double elapsed_s = 0.0;
+
+  /**
+   * @brief Is the homing still running?
+   */
+  bool is_running() const {
+    return phase == HomingPhase::SEARCHING || phase == HomingPhase::RETURNING;
+  }
+};
+
 /**
  * @brief The leg class is the implementation of the LegInterface. This is
  * the decalartion and the definition of the class as it is very simple.
@@ -28,11 +122,54 @@ public:
    *
    */
 
+  /**
+   * @brief TrajectorySample is one reference streamed to the joints by the
+   * trajectory loop, in the order [hip_joint, knee_joint].
+   */
+  struct TrajectorySample {
+    /**
+     * @brief Reference positions (rad).
+     */
+    std::array<double, NUMBER_LEG_JOINTS> position;
+
+    /**
+     * @brief Reference velocities (rad/s), used as feed-forward.
+     */
+    std::array<double, NUMBER_LEG_JOINTS> velocity;
+  };
+
+  /**
+   * @brief Period (s) between two samples of a trajectory, one sample is
+   * streamed per measurement of the boards.
+   */
+  static constexpr double trajectory_period_s = 0.001;
+
+  /**
+   * @brief Maximum number of samples queued, about a minute of motion.
+   */
+  static constexpr size_t trajectory_capacity = 1 << 16;
+
   /**
    * @brief Construct the LegInterface object
+   *
+   * @param hip_joint_module
+   * @param knee_joint_module
+   * @param board is the board both motors are connected to.
+   * @param hold_thread is the scheduling of the thread holding the pose.
+   * @param trajectory_thread is the scheduling of the threads streaming the
+   * trajectories and running the homing.
    */
   Leg(const std::shared_ptr<MotorJointModule> &hip_joint_module,
-      const std::shared_ptr<MotorJointModule> &knee_joint_module) {
+      const std::shared_ptr<MotorJointModule> &knee_joint_module,
+      const Ptr<ControlBoardsInterface> &board,
+      const ThreadPolicy &hold_thread = ThreadPolicy(),
+      const ThreadPolicy &trajectory_thread = ThreadPolicy())
+      : board_(board), trajectory_(trajectory_capacity),
+        hold_monitor_("leg_hold", 0.001),
+        trajectory_monitor_("leg_trajectory", trajectory_period_s) {
+    hold_thread.apply(rt_thread_hold_);
+    trajectory_thread.apply(rt_thread_trajectory_);
+    trajectory_thread.apply(rt_thread_homing_);
 
     joints_[hip_joint] = hip_joint_module;
     joints_[knee_joint] = knee_joint_module;
@@ -47,12 +184,20 @@ public:
 
     initialized = true;
     is_holding = false;
+    hold_period_s_ = 0.001;
+    is_streaming_ = false;
+    queued_samples_ = 0;
+    is_homing_thread_ = false;
   }
 
   /**
    * @brief Destroy the LegInterface object
    */
-  ~Leg() { is_holding = false; }
+  ~Leg() {
+    stop_hold_current_pos();
+    stop_trajectory();
+    stop_homing();
+  }
 
 private:
   /**
@@ -63,24 +208,101 @@ private:
 
 public:
   /**
-   * @brief Calibrate the leg. See motor_joint_module.hpp for explanation of
-   * parameters and logic.
+   * @brief Calibrate the leg and wait for the end of the homing, see
+   * start_homing.
+   *
+   * @return bool true if both joints are homed and at zero.
    */
   bool calibrate(const double &hip_home_offset_rad,
-                 const double &knee_home_offset_rad) {
-    double search_distance_limit_rad = 2 * M_PI;
-    LVector home_offset_rad = {hip_home_offset_rad, knee_home_offset_rad};
+                 const double &knee_home_offset_rad,
+                 const HomingConfig &config = HomingConfig()) {
+    if (!start_homing(hip_home_offset_rad, knee_home_offset_rad, config)) {
+      return false;
+    }
+    HomingProgress progress = get_homing_progress();
+    while (progress.is_running()) {
+      real_time_tools::Timer::sleep_ms(10.0);
+      progress = get_homing_progress();
+    }
+    return progress.phase == HomingPhase::SUCCEEDED;
+  }
 
-    bool status = true;
+  /**
+   * @brief Start homing both joints without blocking. See
+   * motor_joint_module.hpp for the homing on the encoder index. The state
+   * machine runs on the measurements of the boards: both joints follow the
+   * speed profile of the config and a single control frame carries their
+   * torques at every step. Once both indexes are found the joints move to
+   * their zero position and are released.
+   *
+   * @param hip_home_offset_rad hip offset from found encoder index 0 (rad)
+   * @param knee_home_offset_rad knee offset from found encoder index 0 (rad)
+   * @param config
+   * @return bool false if the leg is holding, following a trajectory or
+   * already homing, in which case nothing is started.
+   */
+  bool start_homing(const double &hip_home_offset_rad,
+                    const double &knee_home_offset_rad,
+                    const HomingConfig &config = HomingConfig()) {
+    if (!(config.step_period_s > 0.0) ||
+        !(config.search_acceleration_rad_per_sec2 > 0.0) ||
+        !(config.return_speed_rad_per_sec > 0.0) ||
+        !(std::fabs(config.search_speed_rad_per_sec) > 0.0)) {
+      throw std::invalid_argument("the homing periods, speeds and "
+                                  "acceleration must be positive.");
+    }
+    std::lock_guard<std::mutex> lock(trajectory_door_);
+    if (is_holding || is_streaming_ || get_homing_progress().is_running()) {
+      return false;
+    }
+    if (is_homing_thread_.exchange(false)) {
+      // The previous homing is over, collect its thread.
+      rt_thread_homing_.join();
+    }
 
-    status =
-        status && execute_homing(search_distance_limit_rad, home_offset_rad) ==
-                      HomingReturnCode::SUCCEEDED;
-    LVector zero_pose = LVector::Zero();
-    status = status && go_to(zero_pose) == GoToReturnCode::SUCCEEDED;
+    homing_config_ = config;
+    joints_[hip_joint]->init_homing(config.search_distance_limit_rad,
+                                    hip_home_offset_rad);
+    joints_[knee_joint]->init_homing(config.search_distance_limit_rad,
+                                     knee_home_offset_rad);
+    HomingProgress progress;
+    progress.phase = HomingPhase::SEARCHING;
+    progress.joint_status = {HomingReturnCode::RUNNING,
+                             HomingReturnCode::RUNNING};
+    homing_progress_.store(progress);
+
+    is_homing_thread_ = true;
+    rt_thread_homing_.create_realtime_thread(&Leg::homing_loop, this);
     return true;
   }
 
+  /**
+   * @brief Get the progress of the last homing, it can be called from any
+   * thread.
+   *
+   * @return HomingProgress
+   */
+  HomingProgress get_homing_progress() const {
+    HomingProgress progress;
+    homing_progress_.load(progress);
+    return progress;
+  }
+
+  /**
+   * @brief True while the homing state machine controls the joints.
+   */
+  bool is_homing() const { return get_homing_progress().is_running(); }
+
+  /**
+   * @brief Stop the homing, which then fails, and release the joints.
+   */
+  void stop_homing() {
+    if (!is_homing_thread_.exchange(false)) {
+      return;
+    }
+    rt_thread_homing_.join();
+  }
+
   /**
    * @brief Allow the robot to go to a desired pose. Once the control done
    * 0 torques is sent. By default this function will home.
@@ -99,27 +321,191 @@ public:
   /**
    * @brief Start loop to hold robot at current leg position. Current position
    * is defined as the position meassured when the function was called.
+   *
+   * @param period_s is the period (s) of the position controller. The
+   * controller runs on new measurements, so it never runs faster than the
+   * boards send them (1 kHz).
+   * @return bool false if the leg is homing, in which case nothing is
+   * started.
    */
-  void start_holding_loop() {
+  bool start_holding_loop(const double &period_s = 0.001) {
+    if (!(period_s > 0.0)) {
+      throw std::invalid_argument("the holding period must be positive.");
+    }
+    std::lock_guard<std::mutex> lock(trajectory_door_);
+    if (get_homing_progress().is_running()) {
+      // The homing loop controls the joints.
+      return false;
+    }
+    if (is_streaming_) {
+      // The trajectory loop already holds its last waypoint.
+      return true;
+    }
     // Make sure only one holding loop is running.
-    if (is_holding) {
-      return;
+    bool expected = false;
+    if (!is_holding.compare_exchange_strong(expected, true)) {
+      return true;
     }
-    is_holding = true;
+    hold_period_s_ = period_s;
+    hold_monitor_.set_period(period_s);
+    hold_monitor_.restart();
     rt_thread_hold_.create_realtime_thread(&Leg::hold_current_pos_loop, this);
+    return true;
   }
 
   /**
    * @brief True if currrently holding at some position, otherwise false.
    */
-  bool is_hold_current_pos() { return is_holding; }
+  bool is_hold_current_pos() const { return is_holding; }
 
   /**
-   * @brief Stops any hold loop currently running.
+   * @brief Stops any hold loop currently running and release the joints.
    */
   void stop_hold_current_pos() {
-    is_holding = false;
+    if (!is_holding.exchange(false)) {
+      return;
+    }
     rt_thread_hold_.join();
+
+    joints_[hip_joint]->set_torque(0.0);
+    joints_[knee_joint]->set_torque(0.0);
+    joints_[hip_joint]->send_torque();
+  }
+
+  /**
+   * @brief Queue a trajectory through a list of waypoints without blocking.
+   * Each waypoint is reached with a minimum jerk motion starting from the end
+   * of the previously queued motion, or from the measured position if none
+   * is running. The trajectory is sampled here, the real time loop streams
+   * one sample per measurement with velocity feed-forward and holds the last
+   * waypoint once the queue is empty, until stop_trajectory is called.
+   *
+   * @param waypoints are the positions to go through (rad) in the order
+   * [hip_joint, knee_joint].
+   * @param average_speed_rad_per_sec (rad/sec) of the slowest joint.
+   * @return bool false if the leg is holding a position, is homing or if the
+   * samples would not fit in the queue, in which case nothing is queued.
+   */
+  bool queue_trajectory(
+      const Vector<std::array<double, NUMBER_LEG_JOINTS>> &waypoints,
+      const double &average_speed_rad_per_sec = 1.0) {
+    if (!(average_speed_rad_per_sec > 0.0)) {
+      throw std::invalid_argument("the average speed must be positive.");
+    }
+    std::lock_guard<std::mutex> lock(trajectory_door_);
+    if (is_holding || get_homing_progress().is_running()) {
+      return false;
+    }
+    if (waypoints.empty()) {
+      return true;
+    }
+
+    std::array<double, NUMBER_LEG_JOINTS> start = trajectory_end_;
+    if (!is_streaming_) {
+      start = {joints_[hip_joint]->get_measured_angle(),
+               joints_[knee_joint]->get_measured_angle()};
+    }
+
+    // Plan every segment first, nothing is queued if it does not fit.
+    Vector<double> final_times;
+    Vector<size_t> sample_counts;
+    size_t sample_count = 0;
+    std::array<double, NUMBER_LEG_JOINTS> from = start;
+    for (const auto &waypoint : waypoints) {
+      double distance = 0.0;
+      for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+        distance = std::max(distance, std::fabs(waypoint[i] - from[i]));
+      }
+      final_times.push_back(distance / average_speed_rad_per_sec);
+      sample_counts.push_back(std::max<size_t>(
+          1, std::ceil(final_times.back() / trajectory_period_s)));
+      sample_count += sample_counts.back();
+      from = waypoint;
+    }
+    if (queued_samples_ + sample_count > trajectory_capacity) {
+      return false;
+    }
+
+    // The loop decrements the count once a sample is applied, never below
+    // what was pushed.
+    queued_samples_ += sample_count;
+    from = start;
+    for (size_t w = 0; w < waypoints.size(); w++) {
+      std::array<TimePolynome<5>, NUMBER_LEG_JOINTS> min_jerk_trajs;
+      for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+        min_jerk_trajs[i].set_parameters(final_times[w], from[i],
+                                         0.0 /*initial speed*/,
+                                         waypoints[w][i]);
+      }
+      const Eigen::Index count = sample_counts[w];
+      const Eigen::ArrayXd times = Eigen::ArrayXd::LinSpaced(
+          count, trajectory_period_s, count * trajectory_period_s);
+      Eigen::ArrayXXd positions(count, NUMBER_LEG_JOINTS);
+      Eigen::ArrayXXd velocities(count, NUMBER_LEG_JOINTS);
+      Eigen::ArrayXXd accelerations(count, NUMBER_LEG_JOINTS);
+      compute_time_polynomes<5>(min_jerk_trajs, times, positions, velocities,
+                                accelerations);
+
+      TrajectorySample sample;
+      for (Eigen::Index k = 0; k < count; k++) {
+        for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+          sample.position[i] = positions(k, i);
+          sample.velocity[i] = velocities(k, i);
+        }
+        // always fits, the capacity is checked above.
+        trajectory_.try_push(sample);
+      }
+      from = waypoints[w];
+    }
+    trajectory_end_ = from;
+
+    if (!is_streaming_) {
+      is_streaming_ = true;
+      trajectory_monitor_.restart();
+      rt_thread_trajectory_.create_realtime_thread(&Leg::trajectory_loop,
+                                                   this);
+    }
+    return true;
+  }
+
+  /**
+   * @brief True once every queued sample was sent to the joints.
+   */
+  bool is_trajectory_done() const { return queued_samples_ == 0; }
+
+  /**
+   * @brief True while the trajectory loop controls the joints.
+   */
+  bool is_trajectory_running() const { return is_streaming_; }
+
+  /**
+   * @brief Get the timing of the holding and of the trajectory loops.
+   *
+   * @return Vector<ThreadStats>
+   */
+  Vector<ThreadStats> get_thread_stats() const {
+    return {hold_monitor_.get_stats(), trajectory_monitor_.get_stats()};
+  }
+
+  /**
+   * @brief Stop the trajectory loop, drop the queued samples and release the
+   * joints.
+   */
+  void stop_trajectory() {
+    std::lock_guard<std::mutex> lock(trajectory_door_);
+    if (!is_streaming_.exchange(false)) {
+      return;
+    }
+    rt_thread_trajectory_.join();
+
+    TrajectorySample sample;
+    while (trajectory_.try_pop(sample)) {
+    }
+    queued_samples_ = 0;
+
+    joints_[hip_joint]->set_torque(0.0);
+    joints_[knee_joint]->set_torque(0.0);
+    joints_[hip_joint]->send_torque();
   }
 
 private:
@@ -141,7 +527,76 @@ private:
   /**
    * @brief is Leg holding position?.
    */
-  bool is_holding;
+  std::atomic<bool> is_holding;
+
+  /**
+   * @brief Period (s) of the holding loop.
+   */
+  double hold_period_s_;
+
+  /**
+   * @brief The board both motors are connected to.
+   */
+  Ptr<ControlBoardsInterface> board_;
+
+  /**
+   * @brief The samples queued by queue_trajectory, streamed by the
+   * trajectory_loop.
+   */
+  RingBuffer<TrajectorySample> trajectory_;
+
+  /**
+   * @brief Number of queued samples not applied yet.
+   */
+  std::atomic<size_t> queued_samples_;
+
+  /**
+   * @brief Last waypoint queued, where the next trajectory starts from.
+   */
+  std::array<double, NUMBER_LEG_JOINTS> trajectory_end_;
+
+  /**
+   * @brief Is the trajectory loop running?
+   */
+  std::atomic<bool> is_streaming_;
+
+  /**
+   * @brief The mutex door serializing the planning of the trajectories with
+   * the start and stop of the loops.
+   */
+  std::mutex trajectory_door_;
+
+  /**
+   * @brief the real time thread streaming the trajectories.
+   */
+  real_time_tools::RealTimeThread rt_thread_trajectory_;
+
+  /**
+   * @brief Deadlines of the holding and of the trajectory loops.
+   */
+  DeadlineMonitor hold_monitor_;
+  DeadlineMonitor trajectory_monitor_;
+
+  /**
+   * @brief Is the homing thread created and not joined yet? Clearing it stops
+   * the homing.
+   */
+  std::atomic<bool> is_homing_thread_;
+
+  /**
+   * @brief Configuration of the running homing.
+   */
+  HomingConfig homing_config_;
+
+  /**
+   * @brief Publishes the progress of the homing_loop.
+   */
+  SeqLock<HomingProgress> homing_progress_;
+
+  /**
+   * @brief the real time thread running the homing.
+   */
+  real_time_tools::RealTimeThread rt_thread_homing_;
 
 private:
   /**
@@ -150,99 +605,229 @@ private:
    */
   static THREAD_FUNCTION_RETURN_TYPE
   hold_current_pos_loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
     ((Leg *)(instance_pointer))->hold_current_pos_loop();
     return THREAD_FUNCTION_RETURN_VALUE;
   }
   /**
-   * @brief This loop runs at 1khz and attempts to hold the leg at the position
-   * set when called. This will run as a thread in the background until killed.
+   * @brief This loop attempts to hold the leg at the position set when called.
+   * It wakes up on every new hip measurement and runs the position controller
+   * once per hold_period_s_. This will run as a thread in the background
+   * until killed.
    */
   void hold_current_pos_loop() {
-    double hold_pos_hip = joints_[hip_joint]->get_measured_angle();
-    double hold_pos_knee = joints_[knee_joint]->get_measured_angle();
+    const double hold_pos_hip = joints_[hip_joint]->get_measured_angle();
+    const double hold_pos_knee = joints_[knee_joint]->get_measured_angle();
 
-    real_time_tools::Spinner spinner;
-    spinner.set_period(0.01); // TODO magic number
+    Ptr<const ScalarTimeseries> trigger =
+        joints_[hip_joint]->get_measurement(Measurements::position);
+    Index timeindex = trigger->newest_timeindex(false);
+    double next_update_s = real_time_tools::Timer::get_current_time_sec();
 
     while (is_holding) {
-      double desired_torque =
-          joints_[hip_joint]->execute_position_controller(hold_pos_hip);
-      joints_[hip_joint]->set_torque(desired_torque);
+      // Without new measurements the controller still runs once per period,
+      // the boards must keep receiving controls.
+      if (trigger->wait_for_timeindex(timeindex + 1, hold_period_s_)) {
+        timeindex = trigger->newest_timeindex(false);
+      }
+      // The measurements jitter around the period, accept them half a period
+      // early to avoid skipping one.
+      const double now_s = real_time_tools::Timer::get_current_time_sec();
+      if (now_s + 0.5 * hold_period_s_ < next_update_s) {
+        continue;
+      }
+      next_update_s = std::max(next_update_s + hold_period_s_, now_s);
+      hold_monitor_.tick();
+
+      joints_[hip_joint]->set_torque(
+          joints_[hip_joint]->execute_position_controller(hold_pos_hip));
+      joints_[knee_joint]->set_torque(
+          joints_[knee_joint]->execute_position_controller(hold_pos_knee));
+      // Both motors are on the motor board: a single send commits the pair in
+      // one control frame.
+      joints_[hip_joint]->send_torque();
+    }
+  }
+
+  /**
+   * @brief this function is just a wrapper around the actual trajectory loop,
+   * such that it can be spawned as a posix thread.
+   */
+  static THREAD_FUNCTION_RETURN_TYPE trajectory_loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((Leg *)(instance_pointer))->trajectory_loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief This loop applies one queued sample per new measurement. Once the
+   * queue is empty the last reference is held with a zero velocity.
+   */
+  void trajectory_loop() {
+    Ptr<const ScalarTimeseries> trigger =
+        joints_[hip_joint]->get_measurement(Measurements::position);
+    Index timeindex = trigger->newest_timeindex(false);
+
+    BoardsSnapshot snapshot;
+    TrajectorySample reference;
+    double acceleration;
+    board_->get_snapshot(snapshot);
+    joints_[hip_joint]->read_joint_state(snapshot, reference.position[0],
+                                         reference.velocity[0], acceleration);
+    joints_[knee_joint]->read_joint_state(snapshot, reference.position[1],
+                                          reference.velocity[1], acceleration);
+    reference.velocity = {0.0, 0.0};
+
+    std::array<double, NUMBER_LEG_JOINTS> position, velocity;
+    while (is_streaming_) {
+      // Without new measurements the controls are still sent once per period,
+      // the boards must keep receiving controls.
+      if (trigger->wait_for_timeindex(timeindex + 1, trajectory_period_s)) {
+        timeindex = trigger->newest_timeindex(false);
+      }
+      trajectory_monitor_.tick();
+      const bool is_new_sample = trajectory_.try_pop(reference);
+      if (!is_new_sample) {
+        reference.velocity = {0.0, 0.0};
+      }
+
+      board_->get_snapshot(snapshot);
+      joints_[hip_joint]->read_joint_state(snapshot, position[0], velocity[0],
+                                           acceleration);
+      joints_[knee_joint]->read_joint_state(snapshot, position[1],
+                                            velocity[1], acceleration);
+      joints_[hip_joint]->set_torque(
+          joints_[hip_joint]->execute_position_controller(
+              reference.position[0], reference.velocity[0], position[0],
+              velocity[0]));
+      joints_[knee_joint]->set_torque(
+          joints_[knee_joint]->execute_position_controller(
+              reference.position[1], reference.velocity[1], position[1],
+              velocity[1]));
       joints_[hip_joint]->send_torque();
-      desired_torque =
-          joints_[knee_joint]->execute_position_controller(hold_pos_knee);
-      joints_[knee_joint]->set_torque(desired_torque);
-      joints_[knee_joint]->send_torque();
 
-      spinner.spin();
+      if (is_new_sample) {
+        queued_samples_--;
+      }
     }
   }
 
   /**
-   * @brief Perform homing for all joints.
-   *
-   * If one of the joints fails, the complete homing fails.  Otherwise it
-   * loops until all joints finished.
-   * If a joint is finished while others are still running, it is held at the
-   * home position.
-   *
-   * @param search_distance_limit_rad  Maximum distance the motor moves while
-   *     searching for the encoder index.  Unit: radian.
-   * @param hip_home_offset_rad  Offset from home position to zero position.
-   *     Unit: radian.
-   * @param knee_home_offset_rad  Offset from home position to zero position.
-   *     Unit: radian.
-   * @param profile_step_size_rad  Distance by which the target position of
-   * the position profile is changed in each step.  Set to a negative value to
-   *     search for the next encoder index in negative direction.  Unit:
-   *     radian.
-
-   * @return Final status of the homing procedure (either SUCCESS if all
-   *     joints succeeded or the return code of the first joint that failed).
-   */
-  HomingReturnCode execute_homing(double search_distance_limit_rad,
-                                  LVector home_offset_rad,
-                                  double profile_step_size_rad = 0.001) {
-    // Initialise homing for all joints
-
-    joints_[hip_joint]->init_homing(search_distance_limit_rad,
-                                    home_offset_rad[0], profile_step_size_rad);
-
-    joints_[knee_joint]->init_homing(search_distance_limit_rad,
-                                     home_offset_rad[1], profile_step_size_rad);
-
-    // run homing for all joints until all of them are done
-    real_time_tools::Spinner spinner;
-    spinner.set_period(0.01); // TODO magic number
-    HomingReturnCode homing_status;
-    do {
-      bool all_succeeded = true;
-      homing_status = HomingReturnCode::RUNNING;
-
-      for (const auto &joint_pair : joints_) {
-        HomingReturnCode joint_result = joint_pair.second->update_homing();
-
-        all_succeeded &= (joint_result == HomingReturnCode::SUCCEEDED);
-
-        if (joint_result == HomingReturnCode::NOT_INITIALIZED ||
-            joint_result == HomingReturnCode::FAILED) {
-          homing_status = joint_result;
-          break;
+   * @brief this function is just a wrapper around the actual homing loop,
+   * such that it can be spawned as a posix thread.
+   */
+  static THREAD_FUNCTION_RETURN_TYPE homing_loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((Leg *)(instance_pointer))->homing_loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief Step the homing of both joints once per homing_config_.step_period_s
+   * until they are homed and back at zero, or until a joint fails. The joints
+   * are released at the end.
+   */
+  void homing_loop() {
+    const HomingConfig config = homing_config_;
+    Ptr<const ScalarTimeseries> trigger =
+        joints_[hip_joint]->get_measurement(Measurements::position);
+    Index timeindex = trigger->newest_timeindex(false);
+    const double start_s = real_time_tools::Timer::get_current_time_sec();
+    double next_update_s = start_s;
+
+    HomingProgress progress = get_homing_progress();
+    const double direction = config.search_speed_rad_per_sec > 0.0 ? 1.0 : -1.0;
+    const double cruise_speed = std::fabs(config.search_speed_rad_per_sec);
+    double speed = 0.0;
+    std::array<TimePolynome<5>, NUMBER_LEG_JOINTS> return_trajs;
+    double return_start_s = 0.0;
+
+    while (is_homing_thread_ && progress.is_running()) {
+      if (trigger->wait_for_timeindex(timeindex + 1, config.step_period_s)) {
+        timeindex = trigger->newest_timeindex(false);
+      }
+      const double now_s = real_time_tools::Timer::get_current_time_sec();
+      if (now_s + 0.5 * config.step_period_s < next_update_s) {
+        continue;
+      }
+      next_update_s = std::max(next_update_s + config.step_period_s, now_s);
+      progress.elapsed_s = now_s - start_s;
+
+      if (board_->is_safemode()) {
+        progress.phase = HomingPhase::FAILED;
+      } else if (progress.phase == HomingPhase::SEARCHING) {
+        speed = std::min(cruise_speed,
+                         speed + config.search_acceleration_rad_per_sec2 *
+                                     config.step_period_s);
+        const double step_rad = direction * speed * config.step_period_s;
+        bool all_succeeded = true;
+        for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+          const auto &joint = joints_[static_cast<JointNamesIndex>(i)];
+          const HomingReturnCode status = joint->update_homing(step_rad);
+          const HomingState &state = joint->get_homing_state();
+          progress.joint_status[i] = status;
+          if (status == HomingReturnCode::RUNNING) {
+            progress.search_distance_rad[i] =
+                std::fabs(state.target_position_rad - state.start_position);
+          }
+          all_succeeded &= status == HomingReturnCode::SUCCEEDED;
+          if (status == HomingReturnCode::NOT_INITIALIZED ||
+              status == HomingReturnCode::FAILED) {
+            progress.phase = HomingPhase::FAILED;
+          }
         }
 
-        if (homing_status == HomingReturnCode::RUNNING) {
-          joint_pair.second->send_torque();
+        if (progress.phase != HomingPhase::FAILED && all_succeeded) {
+          // Both zeros are set, move from the home targets to zero.
+          double distance = 0.0;
+          for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+            const auto &joint = joints_[static_cast<JointNamesIndex>(i)];
+            distance = std::max(
+                distance,
+                std::fabs(joint->get_homing_state().target_position_rad));
+          }
+          const double final_time =
+              std::max(distance / config.return_speed_rad_per_sec,
+                       config.step_period_s);
+          for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+            const auto &joint = joints_[static_cast<JointNamesIndex>(i)];
+            return_trajs[i].set_parameters(
+                final_time, joint->get_homing_state().target_position_rad,
+                0.0 /*initial speed*/, 0.0);
+          }
+          return_start_s = now_s;
+          progress.phase = HomingPhase::RETURNING;
+        }
+      } else if (progress.phase == HomingPhase::RETURNING) {
+        const double t = std::min(now_s - return_start_s,
+                                  return_trajs[0].get_final_time());
+        for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
+          const auto &joint = joints_[static_cast<JointNamesIndex>(i)];
+          joint->set_torque(joint->execute_position_controller(
+              return_trajs[i].compute(t), return_trajs[i].compute_derivative(t),
+              joint->get_measured_angle(), joint->get_measured_velocity()));
+        }
+        if (t >= return_trajs[0].get_final_time()) {
+          progress.phase = HomingPhase::SUCCEEDED;
         }
       }
 
-      if (all_succeeded) {
-        homing_status = HomingReturnCode::SUCCEEDED;
+      if (progress.is_running()) {
+        // Both motors are on the motor board: a single send commits the pair
+        // in one control frame.
+        joints_[hip_joint]->send_torque();
       }
+      homing_progress_.store(progress);
+    }
 
-      spinner.spin();
-    } while (homing_status == HomingReturnCode::RUNNING);
-
-    return homing_status;
+    if (progress.is_running()) {
+      // Stopped by stop_homing.
+      progress.phase = HomingPhase::FAILED;
+    }
+    joints_[hip_joint]->set_torque(0.0);
+    joints_[knee_joint]->set_torque(0.0);
+    joints_[hip_joint]->send_torque();
+    homing_progress_.store(progress);
   }
 
   /**
@@ -255,61 +840,19 @@ private:
    */
   GoToReturnCode go_to(LVector angle_to_reach_rad,
                        double average_speed_rad_per_sec = 1.0) {
-    // Compute a min jerk trajectory
-    LVector initial_joint_positions = {
-        joints_[hip_joint]->get_measured_angle(),
-        joints_[knee_joint]->get_measured_angle()};
-
-    double final_time = (angle_to_reach_rad - initial_joint_positions)
-                            .array()
-                            .abs()
-                            .maxCoeff() /
-                        average_speed_rad_per_sec;
-
-    std::array<TimePolynome<5>, NUMBER_LEG_JOINTS> min_jerk_trajs;
-    for (unsigned i = 0; i < NUMBER_LEG_JOINTS; i++) {
-      min_jerk_trajs[i].set_parameters(final_time, initial_joint_positions[i],
-                                       0.0 /*initial speed*/,
-                                       angle_to_reach_rad[i]);
+    // Stream a min jerk trajectory and wait for it to be done.
+    if (!queue_trajectory({{angle_to_reach_rad[0], angle_to_reach_rad[1]}},
+                          average_speed_rad_per_sec)) {
+      return GoToReturnCode::FAILED;
+    }
+    while (!is_trajectory_done()) {
+      real_time_tools::Timer::sleep_ms(trajectory_period_s * 1000.);
     }
-
-    // run got_to for all joints
-    real_time_tools::Spinner spinner;
-    double sampling_period = 0.001; // TODO magic number
-    spinner.set_period(sampling_period);
-    GoToReturnCode go_to_status;
-    double current_time = 0.0;
-
-    double desired_pose;
-    double desired_torque;
-    do {
-      // TODO: add a security if error gets too big
-      desired_pose = min_jerk_trajs[0].compute(current_time);
-      desired_torque =
-          joints_[hip_joint]->execute_position_controller(desired_pose);
-      joints_[hip_joint]->set_torque(desired_torque);
-
-      desired_pose = min_jerk_trajs[1].compute(current_time);
-      desired_torque =
-          joints_[knee_joint]->execute_position_controller(desired_pose);
-      joints_[knee_joint]->set_torque(desired_torque);
-
-      joints_[hip_joint]->send_torque();
-      joints_[knee_joint]->send_torque();
-
-      go_to_status = GoToReturnCode::RUNNING;
-
-      current_time += sampling_period;
-      spinner.spin();
-
-    } while (current_time < (final_time + sampling_period));
 
     // Stop all motors (0 torques) after the destination achieved
-    for (const auto &joint_pair : joints_) {
-      joint_pair.second->set_torque(0.0);
-      joint_pair.second->send_torque();
-    }
+    stop_trajectory();
 
+    GoToReturnCode go_to_status;
     LVector final_pos = {joints_[hip_joint]->get_measured_angle(),
                          joints_[knee_joint]->get_measured_angle()};
     if ((angle_to_reach_rad - final_pos).isMuchSmallerThan(1.0, 1e-3)) {
@@ -142,6 +142,14 @@ public:
    */
   virtual double get_measured_torque() const;
 
+  /**
+   * @brief Get the measured joint torque from a board snapshot.
+   *
+   * @param snapshot is a snapshot obtained from the ControlBoardsInterface.
+   * @return double (Nm), NaN if the current was never received.
+   */
+  virtual double get_measured_torque(const BoardsSnapshot &snapshot) const;
+
   /**
    * @brief Set control gains for PD position controller.
    *
@@ -159,6 +167,23 @@ public:
    */
   double execute_position_controller(double target_position_rad) const;
 
+  /**
+   * @brief Execute one iteration of the position controller with velocity
+   * feed-forward on an already measured state, e.g. from a BoardsSnapshot.
+   *
+   * @param target_position_rad Target position (rad).
+   * @param target_velocity_rad_per_sec Target velocity (rad/s).
+   * @param measured_position_rad Measured position (rad).
+   * @param measured_velocity_rad_per_sec Measured velocity (rad/s).
+   *
+   * @return Torque command (Nm).
+   */
+  double execute_position_controller(
+      const double &target_position_rad,
+      const double &target_velocity_rad_per_sec,
+      const double &measured_position_rad,
+      const double &measured_velocity_rad_per_sec) const;
+
   /**
    * @brief Set zero position relative to current position
    *
@@ -208,6 +233,24 @@ public:
    */
   HomingReturnCode update_homing();
 
+  /**
+   * @brief Perform one step of homing with a given step size, such that the
+   * caller can shape the speed profile of the search, see update_homing().
+   *
+   * @param profile_step_size_rad  Distance by which the target position is
+   *     moved in this step, negative to search in negative direction.  Unit:
+   *     radian.
+   * @return Status of the homing procedure.
+   */
+  HomingReturnCode update_homing(const double &profile_step_size_rad);
+
+  /**
+   * @brief Get the state of the homing procedure.
+   *
+   * @return const HomingState&
+   */
+  const HomingState &get_homing_state() const { return homing_state_; }
+
   /**
    * @brief Get distance between start and end position of homing.
    *
@@ -42,6 +42,8 @@
 
 #include <linux/can.h>
 #include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 
 #include <limits.h>
 
@@ -218,9 +220,11 @@ typedef std::condition_variable ConditionVariable;
  * @param flags
  * @param to
  * @param tolen
+ * @return size_t the number of failed attempts before the frame was sent.
  */
-inline void send_to_can_device(int fd, const void *buf, size_t len, int flags,
-                               const struct sockaddr *to, socklen_t tolen) {
+inline size_t send_to_can_device(int fd, const void *buf, size_t len,
+                                 int flags, const struct sockaddr *to,
+                                 socklen_t tolen) {
   // int ret = rt_dev_sendto(fd, buf, len, flags, to, tolen);
 
   // if (ret < 0)
@@ -239,7 +243,7 @@ inline void send_to_can_device(int fd, const void *buf, size_t len, int flags,
         std::cout << " Managed to send after " << i << " attempts."
                   << std::endl;
       }
-      return;
+      return i;
     }
 
     if (i == 0) {
@@ -287,6 +291,32 @@ inline void receive_message_from_can_device(int fd, struct msghdr *msg,
   }
 }
 
+#ifndef __XENO__
+/**
+ * @brief Receive several messages from the CAN device in a single system call.
+ * This blocks until at least one message is available and then returns all
+ * messages already queued, up to vlen.
+ *
+ * @param fd is the socket of the CAN device.
+ * @param msgvec are the message headers to be filled.
+ * @param vlen is the number of message headers in msgvec.
+ * @return unsigned int the number of messages received.
+ */
+inline unsigned int receive_messages_from_can_device(int fd,
+                                                     struct mmsghdr *msgvec,
+                                                     unsigned int vlen) {
+  int ret = recvmmsg(fd, msgvec, vlen, MSG_WAITFORONE, NULL);
+  if (ret < 0) {
+    std::ostringstream oss;
+    oss << "something went wrong with receiving "
+        << "CAN frames, error code: " << ret << ", errno=" << errno
+        << std::endl;
+    throw std::runtime_error(oss.str());
+  }
+  return ret;
+}
+#endif
+
 /**
  * @brief This function is needed in xenomai to initialize the real time console
  * display of text.
@@ -12,6 +12,8 @@
 
 #include <array>
 
+#include <Eigen/Core>
+
 namespace monopod_drivers {
 /**
  * @brief Simple class that defines \f$ P(x) \f$ a polynome of order ORDER.
@@ -40,6 +42,21 @@ public:
   /*! Compute the value of the second derivative. */
   double compute_sec_derivative(double x);
 
+  /**
+   * @brief Compute the value and the two first derivatives at many points at
+   * once. A single Horner pass gives the three of them and is vectorized over
+   * the points.
+   *
+   * @param x are the points.
+   * @param value \f$ P(x) \f$, same size as x.
+   * @param derivative \f$ \frac{dP}{dx}(x) \f$, same size as x.
+   * @param sec_derivative \f$ \frac{dP^2}{dx^2}(x) \f$, same size as x.
+   */
+  void compute(const Eigen::Ref<const Eigen::ArrayXd> &x,
+               Eigen::Ref<Eigen::ArrayXd> value,
+               Eigen::Ref<Eigen::ArrayXd> derivative,
+               Eigen::Ref<Eigen::ArrayXd> sec_derivative) const;
+
   /*! Get the coefficients. */
   void get_coefficients(Coefficients &coefficients) const;
 
@@ -89,6 +106,20 @@ public:
   /*! Compute the value of the second derivative. */
   double compute_sec_derivative(double t);
 
+  /**
+   * @brief Compute the value and the two first derivatives at many times at
+   * once, saturated outside of [0, final_time] as the single time versions.
+   *
+   * @param t are the times.
+   * @param value \f$ P(t) \f$, same size as t.
+   * @param derivative \f$ \frac{dP}{dt}(t) \f$, same size as t.
+   * @param sec_derivative \f$ \frac{dP^2}{dt^2}(t) \f$, same size as t.
+   */
+  void compute(const Eigen::Ref<const Eigen::ArrayXd> &t,
+               Eigen::Ref<Eigen::ArrayXd> value,
+               Eigen::Ref<Eigen::ArrayXd> derivative,
+               Eigen::Ref<Eigen::ArrayXd> sec_derivative) const;
+
   double get_final_time() const { return final_time_; }
   double get_init_pose() const { return init_pose_; }
   double get_init_speed() const { return init_speed_; }
@@ -127,6 +158,26 @@ protected:
   double final_acc_;   /**< store the inputs for later access */
 };
 
+/**
+ * @brief Compute several time polynomes, e.g. one per joint, at the same
+ * times. Column j of the outputs is polynome j.
+ *
+ * @tparam ORDER of the polynomes.
+ * @tparam Polynomes is any container of TimePolynome<ORDER> with size() and
+ * operator[].
+ * @param polynomes are the polynomes to be computed.
+ * @param t are the times.
+ * @param value is (t.size() x polynomes.size()).
+ * @param derivative is (t.size() x polynomes.size()).
+ * @param sec_derivative is (t.size() x polynomes.size()).
+ */
+template <int ORDER, typename Polynomes>
+void compute_time_polynomes(const Polynomes &polynomes,
+                            const Eigen::Ref<const Eigen::ArrayXd> &t,
+                            Eigen::Ref<Eigen::ArrayXXd> value,
+                            Eigen::Ref<Eigen::ArrayXXd> derivative,
+                            Eigen::Ref<Eigen::ArrayXXd> sec_derivative);
+
 } // namespace monopod_drivers
 
 #include "monopod_sdk/monopod_drivers/utils/polynome.hxx"
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 namespace monopod_drivers {
@@ -53,6 +54,28 @@ template <int ORDER> double Polynome<ORDER>::compute_sec_derivative(double x) {
   return res;
 }
 
+template <int ORDER>
+void Polynome<ORDER>::compute(const Eigen::Ref<const Eigen::ArrayXd> &x,
+                              Eigen::Ref<Eigen::ArrayXd> value,
+                              Eigen::Ref<Eigen::ArrayXd> derivative,
+                              Eigen::Ref<Eigen::ArrayXd> sec_derivative) const {
+  if (value.size() != x.size() || derivative.size() != x.size() ||
+      sec_derivative.size() != x.size()) {
+    throw std::invalid_argument(
+        "Polynome::compute(): the outputs must be of the size of the input.");
+  }
+  // Horner's scheme on P, P' and P''/2 at once.
+  value.setConstant(coefficients_[ORDER]);
+  derivative.setZero();
+  sec_derivative.setZero();
+  for (int i = ORDER - 1; i >= 0; --i) {
+    sec_derivative = sec_derivative * x + derivative;
+    derivative = derivative * x + value;
+    value = value * x + coefficients_[i];
+  }
+  sec_derivative *= 2.0;
+}
+
 template <int ORDER>
 void Polynome<ORDER>::get_coefficients(Coefficients &coefficients) const {
   coefficients = coefficients_;
@@ -105,4 +128,41 @@ double TimePolynome<ORDER>::compute_sec_derivative(double t) {
   }
 }
 
+template <int ORDER>
+void TimePolynome<ORDER>::compute(
+    const Eigen::Ref<const Eigen::ArrayXd> &t, Eigen::Ref<Eigen::ArrayXd> value,
+    Eigen::Ref<Eigen::ArrayXd> derivative,
+    Eigen::Ref<Eigen::ArrayXd> sec_derivative) const {
+  Polynome<ORDER>::compute(t, value, derivative, sec_derivative);
+  // The initial values are selected last to win over the final ones, as in
+  // the scalar versions, e.g. if final_time_ <= 0.
+  value = (t >= final_time_).select(final_pose_, value);
+  value = (t <= 0.0).select(init_pose_, value);
+  derivative = (t >= final_time_).select(final_speed_, derivative);
+  derivative = (t <= 0.0).select(init_speed_, derivative);
+  sec_derivative = (t >= final_time_).select(final_acc_, sec_derivative);
+  sec_derivative = (t <= 0.0).select(init_acc_, sec_derivative);
+}
+
+template <int ORDER, typename Polynomes>
+void compute_time_polynomes(const Polynomes &polynomes,
+                            const Eigen::Ref<const Eigen::ArrayXd> &t,
+                            Eigen::Ref<Eigen::ArrayXXd> value,
+                            Eigen::Ref<Eigen::ArrayXXd> derivative,
+                            Eigen::Ref<Eigen::ArrayXXd> sec_derivative) {
+  const Eigen::Index count = polynomes.size();
+  if (value.rows() != t.size() || value.cols() != count ||
+      derivative.rows() != t.size() || derivative.cols() != count ||
+      sec_derivative.rows() != t.size() || sec_derivative.cols() != count) {
+    throw std::invalid_argument("compute_time_polynomes(): the outputs must "
+                                "be (times x polynomes).");
+  }
+  // The columns are contiguous, each polynome is vectorized over the times.
+  for (Eigen::Index j = 0; j < count; ++j) {
+    const TimePolynome<ORDER> &polynome = polynomes[j];
+    polynome.compute(t, value.col(j), derivative.col(j),
+                     sec_derivative.col(j));
+  }
+}
+
 } // namespace monopod_drivers
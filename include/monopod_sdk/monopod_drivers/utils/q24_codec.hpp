@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace monopod_drivers {
+
+/**
+ * @brief Conversions between the payloads of the blmc cards and floats.
+ *
+ * The cards send and receive 8 bytes payloads holding two big-endian 32 bits
+ * integers, usually Q24 fixed-point values, i.e. the value times 2^24. The
+ * kernels below are branch free and work on whole payloads, such that the
+ * compiler can vectorize the batch variants.
+ */
+
+/*! Value of the least significant bit of a Q24 integer. */
+constexpr double q24_resolution = 1.0 / (1 << 24);
+
+/*! Range of the floats which can be converted to Q24 integers. */
+constexpr float q24_min = -128.0f;
+constexpr float q24_max = 127.99999237060546875f; // 128 - 2^-17
+
+/**
+ * @brief Read a big-endian 32 bits integer.
+ *
+ * @param bytes points to the 4 bytes of the integer.
+ * @return int32_t
+ */
+inline int32_t decode_int32(const uint8_t *bytes) {
+  uint32_t value;
+  std::memcpy(&value, bytes, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  value = __builtin_bswap32(value);
+#endif
+  return static_cast<int32_t>(value);
+}
+
+/**
+ * @brief Write a big-endian 32 bits integer.
+ *
+ * @param value
+ * @param bytes points to the 4 bytes to write.
+ */
+inline void encode_int32(const int32_t &value, uint8_t *bytes) {
+  uint32_t big_endian = static_cast<uint32_t>(value);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  big_endian = __builtin_bswap32(big_endian);
+#endif
+  std::memcpy(bytes, &big_endian, sizeof(big_endian));
+}
+
+/**
+ * @brief Convert from 24-bit normalized fixed-point to float.
+ *
+ * @param q_value
+ * @return float
+ */
+inline float q24_to_float(const int32_t &q_value) {
+  return static_cast<float>(q_value) * static_cast<float>(q24_resolution);
+}
+
+/**
+ * @brief Convert from float to 24-bit normalized fixed-point, rounding
+ * towards zero. The values out of [q24_min, q24_max] saturate and NaN gives
+ * 0, such that the conversion is always defined.
+ *
+ * @param value
+ * @return int32_t
+ */
+inline int32_t float_to_q24(float value) {
+  value = value == value ? value : 0.0f;
+  value = std::min(q24_max, std::max(q24_min, value));
+  return static_cast<int32_t>(value * (1 << 24));
+}
+
+/**
+ * @brief Read the two integers of a payload.
+ *
+ * @param data points to the 8 bytes of the payload.
+ * @param first is set to the integer in bytes 0 to 3.
+ * @param second is set to the integer in bytes 4 to 7.
+ */
+inline void decode_int32_pair(const uint8_t *data, int32_t &first,
+                              int32_t &second) {
+  first = decode_int32(data);
+  second = decode_int32(data + 4);
+}
+
+/**
+ * @brief Write the two integers of a payload.
+ *
+ * @param first goes to bytes 0 to 3.
+ * @param second goes to bytes 4 to 7.
+ * @param data points to the 8 bytes of the payload.
+ */
+inline void encode_int32_pair(const int32_t &first, const int32_t &second,
+                              uint8_t *data) {
+  encode_int32(first, data);
+  encode_int32(second, data + 4);
+}
+
+/**
+ * @brief Read the two Q24 values of a payload.
+ *
+ * @param data points to the 8 bytes of the payload.
+ * @param first
+ * @param second
+ */
+inline void decode_q24_pair(const uint8_t *data, float &first,
+                            float &second) {
+  first = q24_to_float(decode_int32(data));
+  second = q24_to_float(decode_int32(data + 4));
+}
+
+/**
+ * @brief Write two Q24 values to a payload, see float_to_q24.
+ *
+ * @param first
+ * @param second
+ * @param data points to the 8 bytes of the payload.
+ */
+inline void encode_q24_pair(const float &first, const float &second,
+                            uint8_t *data) {
+  encode_int32_pair(float_to_q24(first), float_to_q24(second), data);
+}
+
+/**
+ * @brief Read the Q24 values of an array of frames, e.g. a recorded log.
+ *
+ * @tparam Frame is any type with a `data` array of 8 bytes, e.g. CanBusFrame.
+ * @param frames
+ * @param count is the number of frames.
+ * @param first receives the first value of each frame.
+ * @param second receives the second value of each frame.
+ */
+template <typename Frame>
+void decode_q24_pairs(const Frame *frames, const size_t &count, float *first,
+                      float *second) {
+  for (size_t i = 0; i < count; i++) {
+    decode_q24_pair(frames[i].data.data(), first[i], second[i]);
+  }
+}
+
+/**
+ * @brief Write Q24 values to an array of frames, only the payloads are set.
+ *
+ * @tparam Frame is any type with a `data` array of 8 bytes, e.g. CanBusFrame.
+ * @param first holds the first value of each frame.
+ * @param second holds the second value of each frame.
+ * @param count is the number of frames.
+ * @param frames
+ */
+template <typename Frame>
+void encode_q24_pairs(const float *first, const float *second,
+                      const size_t &count, Frame *frames) {
+  for (size_t i = 0; i < count; i++) {
+    encode_q24_pair(first[i], second[i], frames[i].data.data());
+  }
+}
+
+} // namespace monopod_drivers
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace monopod_drivers {
+
+/**
+ * @brief Bounded lock-free ring buffer supporting several producers and
+ * several consumers (D. Vyukov's bounded MPMC queue).
+ *
+ * All the slots are allocated on construction, pushing and popping never
+ * allocate nor wait. If the buffer is full try_push fails, it is up to the
+ * producer to drop the element.
+ *
+ * @tparam T is the type of the elements.
+ */
+template <typename T> class RingBuffer {
+public:
+  /**
+   * @brief Construct a new RingBuffer object.
+   *
+   * @param capacity is the number of elements, it must be a power of two.
+   */
+  RingBuffer(const size_t &capacity)
+      : mask_(capacity - 1), slots_(new Slot[capacity]), head_(0), tail_(0) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+      throw std::invalid_argument(
+          "The capacity of a RingBuffer must be a power of two.");
+    }
+    for (size_t i = 0; i < capacity; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Add an element.
+   *
+   * @param value is the element to be added.
+   * @return bool false if the buffer is full.
+   */
+  bool try_push(const T &value) {
+    size_t position = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots_[position & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+      if (difference == 0) {
+        if (head_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Remove the oldest element.
+   *
+   * @param value is filled with the removed element.
+   * @return bool false if the buffer is empty.
+   */
+  bool try_pop(T &value) {
+    size_t position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots_[position & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+      if (difference == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          value = slot.value;
+          slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Get the capacity of the buffer.
+   *
+   * @return size_t
+   */
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  /**
+   * @brief A slot holds an element and the turn it belongs to.
+   */
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  /**
+   * @brief capacity - 1, used to wrap the positions.
+   */
+  const size_t mask_;
+
+  /**
+   * @brief The preallocated slots.
+   */
+  std::unique_ptr<Slot[]> slots_;
+
+  /**
+   * @brief Position of the next element to be pushed.
+   */
+  alignas(64) std::atomic<size_t> head_;
+
+  /**
+   * @brief Position of the next element to be popped.
+   */
+  alignas(64) std::atomic<size_t> tail_;
+};
+
+} // namespace monopod_drivers
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace monopod_drivers {
+
+/**
+ * @brief Simple sequence lock publishing a trivially copyable value from one
+ * writer thread to any number of reader threads.
+ *
+ * The writer never waits and readers never take a lock: a reader copies the
+ * value and simply retries if the writer updated it in the meantime. The
+ * value is stored as an array of atomic words such that the concurrent copy
+ * is well defined.
+ *
+ * @tparam T is the type of the published value, it must be trivially
+ * copyable.
+ */
+template <typename T> class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock requires a trivially copyable type.");
+
+  /*! Number of 64 bits words used to store the value. */
+  static constexpr size_t word_count =
+      (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+  /**
+   * @brief Construct a new SeqLock object holding a value initialized T.
+   */
+  SeqLock() : sequence_(0) { store(T()); }
+
+  /**
+   * @brief Publish a new value. Must only be called from a single thread at
+   * a time.
+   *
+   * @param value is the value to be published.
+   */
+  void store(const T &value) {
+    std::array<uint64_t, word_count> words = {};
+    std::memcpy(words.data(), &value, sizeof(T));
+
+    const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    // An odd sequence tells the readers a write is in progress.
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < word_count; i++) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy the newest coherent value.
+   *
+   * @param value is filled with the newest published value.
+   * @return uint64_t the version of the value, incremented by every store.
+   */
+  uint64_t load(T &value) const {
+    std::array<uint64_t, word_count> words;
+    uint64_t before, after;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < word_count; i++) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+    return before / 2;
+  }
+
+private:
+  /**
+   * @brief Incremented twice per store, odd while a store is in progress.
+   */
+  alignas(64) std::atomic<uint64_t> sequence_;
+
+  /**
+   * @brief Storage of the published value.
+   */
+  std::array<std::atomic<uint64_t>, word_count> words_;
+};
+
+} // namespace monopod_drivers
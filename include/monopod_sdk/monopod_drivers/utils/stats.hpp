@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace monopod_drivers {
+
+/**
+ * @brief Get the wall clock time (ns). This is the clock the kernel uses to
+ * timestamp the received CAN frames, all the latencies are measured against
+ * it such that they can be compared with the frame timestamps.
+ *
+ * @return uint64_t
+ */
+inline uint64_t get_wall_time_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief LatencySummary is a copy of the content of a LatencyHistogram at some
+ * point in time. All the values are in ns, the percentiles are the upper bound
+ * of the bucket they fall in.
+ */
+struct LatencySummary {
+  uint64_t count = 0;
+  uint64_t min_ns = 0;
+  uint64_t max_ns = 0;
+  double mean_ns = 0.0;
+  uint64_t p50_ns = 0;
+  uint64_t p90_ns = 0;
+  uint64_t p99_ns = 0;
+  uint64_t p999_ns = 0;
+};
+
+/**
+ * @brief LatencyHistogram counts durations in log-linear buckets, like an HDR
+ * histogram: every power of two is split in sub_bucket_count linear buckets,
+ * so the relative error of a bucket is below 1 / sub_bucket_count from 1 ns
+ * up to max_value_ns.
+ *
+ * Recording is wait free and does not allocate, it can be called from any
+ * real-time thread concurrently with the readers.
+ */
+class LatencyHistogram {
+public:
+  /*! Number of linear buckets per power of two. */
+  static constexpr int sub_bucket_bits = 4;
+  static constexpr uint64_t sub_bucket_count = 1 << sub_bucket_bits;
+
+  /*! Highest power of two recorded, larger values go to the last bucket. */
+  static constexpr int max_exponent = 40;
+  static constexpr uint64_t max_value_ns = (uint64_t(2) << max_exponent) - 1;
+
+  /*! Total number of buckets. */
+  static constexpr size_t bucket_count =
+      (max_exponent - sub_bucket_bits + 2) * sub_bucket_count;
+
+  /**
+   * @brief Construct a new empty LatencyHistogram object.
+   */
+  LatencyHistogram() { reset(); }
+
+  /**
+   * @brief Count one value.
+   *
+   * @param value_ns is the duration (ns).
+   */
+  void record(const uint64_t &value_ns) {
+    buckets_[get_bucket(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+
+    uint64_t min = min_.load(std::memory_order_relaxed);
+    while (value_ns < min &&
+           !min_.compare_exchange_weak(min, value_ns,
+                                       std::memory_order_relaxed)) {
+    }
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value_ns > max &&
+           !max_.compare_exchange_weak(max, value_ns,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief Count the time elapsed between start_ns and now.
+   *
+   * @param start_ns is a time given by get_wall_time_ns. Starts in the future,
+   * e.g. bogus timestamps, are ignored.
+   */
+  void record_since(const uint64_t &start_ns) {
+    const uint64_t now_ns = get_wall_time_ns();
+    if (start_ns != 0 && now_ns >= start_ns) {
+      record(now_ns - start_ns);
+    }
+  }
+
+  /**
+   * @brief Get a summary of the values counted so far. The counters are read
+   * one by one, so the summary is only approximately coherent while values
+   * are recorded.
+   *
+   * @return LatencySummary
+   */
+  LatencySummary get_summary() const {
+    std::array<uint64_t, bucket_count> buckets;
+    uint64_t count = 0;
+    for (size_t i = 0; i < bucket_count; i++) {
+      buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+      count += buckets[i];
+    }
+
+    LatencySummary summary;
+    summary.count = count;
+    if (count == 0) {
+      return summary;
+    }
+    summary.min_ns = min_.load(std::memory_order_relaxed);
+    summary.max_ns = max_.load(std::memory_order_relaxed);
+    summary.mean_ns = double(sum_.load(std::memory_order_relaxed)) / count;
+
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t *percentiles[] = {&summary.p50_ns, &summary.p90_ns,
+                               &summary.p99_ns, &summary.p999_ns};
+    uint64_t cumulated = 0;
+    size_t quantile = 0;
+    for (size_t i = 0; i < bucket_count && quantile < 4; i++) {
+      cumulated += buckets[i];
+      while (quantile < 4 && cumulated >= quantiles[quantile] * count) {
+        *percentiles[quantile] =
+            std::min(get_bucket_upper_bound(i), summary.max_ns);
+        quantile++;
+      }
+    }
+    return summary;
+  }
+
+  /**
+   * @brief Forget all the values counted so far.
+   */
+  void reset() {
+    for (auto &bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the bucket a value falls in.
+   *
+   * @param value_ns
+   * @return size_t
+   */
+  static size_t get_bucket(uint64_t value_ns) {
+    value_ns = std::min(value_ns, max_value_ns);
+    if (value_ns < sub_bucket_count) {
+      return value_ns;
+    }
+    const int exponent = 63 - __builtin_clzll(value_ns);
+    const int shift = exponent - sub_bucket_bits;
+    return (shift + 1) * sub_bucket_count +
+           ((value_ns >> shift) & (sub_bucket_count - 1));
+  }
+
+  /**
+   * @brief Get the largest value falling in a bucket.
+   *
+   * @param bucket
+   * @return uint64_t
+   */
+  static uint64_t get_bucket_upper_bound(const size_t &bucket) {
+    if (bucket < sub_bucket_count) {
+      return bucket;
+    }
+    const int shift = bucket / sub_bucket_count - 1;
+    const uint64_t lower = (sub_bucket_count + bucket % sub_bucket_count)
+                           << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, bucket_count> buckets_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+};
+
+/**
+ * @brief ThreadStats reports the timing of a periodic real-time thread.
+ */
+struct ThreadStats {
+  /**
+   * @brief Name of the thread.
+   */
+  std::string name;
+
+  /**
+   * @brief Nominal period of the thread (ns).
+   */
+  uint64_t period_ns = 0;
+
+  /**
+   * @brief Number of iterations so far.
+   */
+  uint64_t iterations = 0;
+
+  /**
+   * @brief Number of iterations which started late, see DeadlineMonitor.
+   */
+  uint64_t missed_deadlines = 0;
+
+  /**
+   * @brief Distribution of the time between two iterations.
+   */
+  LatencySummary interval;
+};
+
+/**
+ * @brief DeadlineMonitor follows the iterations of a periodic thread: an
+ * iteration misses its deadline if it started later than one period plus a
+ * tolerance after the previous one.
+ */
+class DeadlineMonitor {
+public:
+  /**
+   * @brief Construct a new DeadlineMonitor object
+   *
+   * @param name of the monitored thread.
+   * @param period_s is the nominal period of the thread (s).
+   * @param tolerance is the admitted lateness, relative to the period.
+   */
+  DeadlineMonitor(const std::string &name, const double &period_s,
+                  const double &tolerance = 0.1)
+      : name_(name), period_ns_(period_s * 1e9),
+        deadline_ns_(period_s * (1.0 + tolerance) * 1e9), last_tick_ns_(0),
+        iterations_(0), missed_deadlines_(0) {}
+
+  /**
+   * @brief Change the nominal period, e.g. when the thread is restarted with
+   * another one. The counters are kept.
+   *
+   * @param period_s
+   * @param tolerance
+   */
+  void set_period(const double &period_s, const double &tolerance = 0.1) {
+    period_ns_ = period_s * 1e9;
+    deadline_ns_ = period_s * (1.0 + tolerance) * 1e9;
+  }
+
+  /**
+   * @brief Start a new series of iterations, the next tick is not checked
+   * against the deadline. Must be called before the thread is (re)started.
+   */
+  void restart() { last_tick_ns_ = 0; }
+
+  /**
+   * @brief Call at every iteration of the thread, from the thread itself.
+   */
+  void tick() {
+    const uint64_t now_ns = get_wall_time_ns();
+    if (last_tick_ns_ != 0 && now_ns > last_tick_ns_) {
+      const uint64_t interval_ns = now_ns - last_tick_ns_;
+      interval_.record(interval_ns);
+      if (interval_ns > deadline_ns_.load(std::memory_order_relaxed)) {
+        missed_deadlines_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    last_tick_ns_ = now_ns;
+    iterations_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the statistics of the thread.
+   *
+   * @return ThreadStats
+   */
+  ThreadStats get_stats() const {
+    ThreadStats stats;
+    stats.name = name_;
+    stats.period_ns = period_ns_.load(std::memory_order_relaxed);
+    stats.iterations = iterations_.load(std::memory_order_relaxed);
+    stats.missed_deadlines = missed_deadlines_.load(std::memory_order_relaxed);
+    stats.interval = interval_.get_summary();
+    return stats;
+  }
+
+private:
+  const std::string name_;
+  std::atomic<uint64_t> period_ns_;
+  std::atomic<uint64_t> deadline_ns_;
+
+  /*! Only accessed by the monitored thread. */
+  uint64_t last_tick_ns_;
+
+  std::atomic<uint64_t> iterations_;
+  std::atomic<uint64_t> missed_deadlines_;
+  LatencyHistogram interval_;
+};
+
+} // namespace monopod_drivers
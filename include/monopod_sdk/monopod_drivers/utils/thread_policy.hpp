@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+
+#include <real_time_tools/thread.hpp>
+
+namespace monopod_drivers {
+
+/**
+ * @brief ThreadPolicy sets how one of the real-time threads of the sdk is
+ * scheduled. The default leaves the thread to the defaults of
+ * real_time_tools: SCHED_FIFO at priority 80, not pinned.
+ */
+struct ThreadPolicy {
+  /**
+   * @brief CPU the thread is pinned to, not pinned if negative.
+   */
+  int cpu = -1;
+
+  /**
+   * @brief SCHED_FIFO priority of the thread (1 to 99), the default of
+   * real_time_tools if negative.
+   */
+  int priority = -1;
+
+  /**
+   * @brief Size of the stack of the thread (bytes), the default of
+   * real_time_tools if 0.
+   */
+  size_t stack_size = 0;
+
+  /**
+   * @brief Get the policy pinning a thread to a CPU.
+   *
+   * @param cpu
+   * @param priority
+   * @return ThreadPolicy
+   */
+  static ThreadPolicy pinned(const int &cpu, const int &priority = -1) {
+    ThreadPolicy policy;
+    policy.cpu = cpu;
+    policy.priority = priority;
+    return policy;
+  }
+
+  /**
+   * @brief Get the policy of a thread which is not pinned.
+   *
+   * @param priority
+   * @return ThreadPolicy
+   */
+  static ThreadPolicy with_priority(const int &priority) {
+    return pinned(-1, priority);
+  }
+
+  /**
+   * @brief Set the parameters of a thread to this policy. The thread keeps
+   * them for every create_realtime_thread which follows.
+   *
+   * @param thread
+   * @throw std::invalid_argument if the priority is out of range.
+   */
+  void apply(real_time_tools::RealTimeThread &thread) const;
+};
+
+/**
+ * @brief MemoryPolicy avoids the page faults of the process once the real-time
+ * threads run: the pages are locked in RAM and the heap and the stacks are
+ * touched beforehand.
+ */
+struct MemoryPolicy {
+  /**
+   * @brief Lock the current and future pages of the process in RAM, see
+   * mlockall. The stacks of the threads created afterwards are then
+   * prefaulted by the kernel.
+   */
+  bool lock_memory = false;
+
+  /**
+   * @brief Number of bytes of heap to fault in and keep in the process, such
+   * that later allocations do not hit the kernel.
+   */
+  size_t heap_prefault_bytes = 0;
+
+  /**
+   * @brief Number of bytes of the stack to fault in, for the calling thread
+   * and for each real-time thread of the sdk when it starts. It must be less
+   * than the stack size of the threads, see ThreadPolicy::stack_size.
+   */
+  size_t stack_prefault_bytes = 0;
+
+  /**
+   * @brief Apply the policy to the calling process. Failing to lock the
+   * memory, e.g. without the CAP_IPC_LOCK capability, is reported but not
+   * fatal.
+   *
+   * @return bool true if every step succeeded.
+   */
+  bool apply() const;
+
+  /**
+   * @brief Fault in the stack of the calling thread as set by the last
+   * applied policy, see stack_prefault_bytes. This is called by each
+   * real-time thread of the sdk before it enters its loop.
+   */
+  static void prefault_thread_stack();
+};
+
+} // namespace monopod_drivers
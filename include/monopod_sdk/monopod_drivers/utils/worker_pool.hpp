@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace monopod_drivers {
+
+/**
+ * @brief WorkerPool splits a range of independent tasks over a fixed set of
+ * threads, e.g. the robots of a MonopodArray.
+ *
+ * The threads are plain std::thread: the pool is meant for the simulation
+ * running on a workstation, where real-time privileges are usually missing.
+ * The calling thread takes part in the work, such that a pool of one worker
+ * runs everything inline.
+ */
+class WorkerPool {
+public:
+  /**
+   * @brief Contiguous range of tasks [begin, end).
+   */
+  typedef std::function<void(const size_t &begin, const size_t &end)> Job;
+
+  /**
+   * @brief Construct a new WorkerPool object.
+   *
+   * @param worker_count is the number of threads running the tasks, the
+   * calling one included. 0 uses one per hardware thread.
+   */
+  explicit WorkerPool(const size_t &worker_count = 0);
+
+  /**
+   * @brief Destroy the WorkerPool object, joins the threads.
+   */
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  /**
+   * @brief Run the tasks [0, task_count) and wait for all of them. The range
+   * is cut into one contiguous block per worker. Must not be called
+   * concurrently.
+   *
+   * @param task_count
+   * @param job is called once per non-empty block, it must not throw.
+   */
+  void run(const size_t &task_count, const Job &job);
+
+  /**
+   * @brief Get the number of workers, the calling thread included.
+   *
+   * @return size_t
+   */
+  size_t get_worker_count() const { return threads_.size() + 1; }
+
+private:
+  /**
+   * @brief Wait for the jobs and run the block of the given worker.
+   *
+   * @param worker is the index of the block, 0 is the calling thread.
+   */
+  void work(const size_t &worker);
+
+  /**
+   * @brief Run the block of a worker.
+   *
+   * @param worker
+   */
+  void run_block(const size_t &worker);
+
+  /**
+   * @brief Mutex protecting the job.
+   */
+  std::mutex door_;
+
+  /**
+   * @brief Signals a new job to the threads.
+   */
+  std::condition_variable job_condition_;
+
+  /**
+   * @brief Signals the end of the blocks to the caller of run.
+   */
+  std::condition_variable done_condition_;
+
+  /**
+   * @brief The running job and its number of tasks.
+   */
+  const Job *job_;
+  size_t task_count_;
+
+  /**
+   * @brief Incremented for every job, such that each thread runs it once.
+   */
+  uint64_t generation_;
+
+  /**
+   * @brief Number of threads still running their block.
+   */
+  size_t pending_workers_;
+
+  /**
+   * @brief Are the threads asked to stop?
+   */
+  bool is_stopping_;
+
+  /**
+   * @brief The threads, the calling thread is the worker 0.
+   */
+  std::vector<std::thread> threads_;
+};
+
+} // namespace monopod_drivers
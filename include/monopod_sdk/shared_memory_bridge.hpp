@@ -0,0 +1,225 @@
+#pragma once
+
+#include <real_time_tools/spinner.hpp>
+#include <real_time_tools/thread.hpp>
+#include <time_series/multiprocess_time_series.hpp>
+
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "monopod_sdk/common_header.hpp"
+#include "monopod_sdk/monopod.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief TorqueCommand is a set of joint torques sent by an out-of-process
+ * controller through the SharedMemoryBridge.
+ */
+struct TorqueCommand {
+  /**
+   * @brief Construct a new TorqueCommand object commanding no joint.
+   */
+  TorqueCommand() : joints(0) { torque.fill(0.0); }
+
+  /**
+   * @brief Desired torque (Nm) indexed by JointNamesIndex.
+   */
+  std::array<double, NUMBER_JOINTS> torque;
+
+  /**
+   * @brief Bit (1 << JointNamesIndex) is set if the torque of the joint is
+   * commanded.
+   */
+  uint32_t joints;
+
+  /**
+   * @brief Serialize the command, used to share it between processes.
+   */
+  template <class Archive> void serialize(Archive &archive) {
+    for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+      archive(torque[i]);
+    }
+    archive(joints);
+  }
+};
+
+/**
+ * @brief A useful shortcut
+ */
+typedef time_series::MultiprocessTimeSeries<StateSnapshot>
+    SharedStateTimeseries;
+
+/**
+ * @brief A useful shortcut
+ */
+typedef time_series::MultiprocessTimeSeries<TorqueCommand>
+    SharedCommandTimeseries;
+
+/**
+ * @brief SharedMemoryBridge exposes a Monopod to other processes. It publishes
+ * the joint states to a time series in shared memory and applies the torque
+ * commands other processes append to a second one. Any number of
+ * SharedMemoryClient can attach to the same segment.
+ *
+ * The bridge runs in its own low priority thread, see RealtimeConfig::bridge,
+ * and only reads the state snapshot of the Monopod, so it adds no work to the
+ * real-time threads.
+ */
+class SharedMemoryBridge {
+public:
+  /**
+   * @brief Construct a new SharedMemoryBridge object and start publishing.
+   *
+   * @param monopod is the initialized Monopod to be exposed.
+   * @param segment_id is the prefix of the shared memory segments.
+   * @param history_length is the number of states and commands kept.
+   * @param period_s is the period (s) at which the state is polled.
+   */
+  SharedMemoryBridge(Ptr<Monopod> monopod,
+                     const std::string &segment_id = "monopod",
+                     const size_t &history_length = 1000,
+                     const double &period_s = 0.001);
+
+  /**
+   * @brief Destroy the SharedMemoryBridge object and stop publishing.
+   */
+  ~SharedMemoryBridge();
+
+  /**
+   * @brief Get the name of the segment holding the states.
+   *
+   * @param segment_id is the prefix of the shared memory segments.
+   * @return std::string
+   */
+  static std::string state_segment(const std::string &segment_id) {
+    return segment_id + "_state";
+  }
+
+  /**
+   * @brief Get the name of the segment holding the commands.
+   *
+   * @param segment_id is the prefix of the shared memory segments.
+   * @return std::string
+   */
+  static std::string command_segment(const std::string &segment_id) {
+    return segment_id + "_command";
+  }
+
+private:
+  /**
+   * @brief this function is just a wrapper around the actual loop function,
+   * such that it can be spawned as a posix thread.
+   */
+  static THREAD_FUNCTION_RETURN_TYPE loop(void *instance_pointer) {
+    MemoryPolicy::prefault_thread_stack();
+    ((SharedMemoryBridge *)(instance_pointer))->loop();
+    return THREAD_FUNCTION_RETURN_VALUE;
+  }
+
+  /**
+   * @brief Publish the new states and apply the new commands.
+   */
+  void loop();
+
+  /**
+   * @brief The exposed Monopod.
+   */
+  Ptr<Monopod> monopod_;
+
+  /**
+   * @brief The prefix of the shared memory segments.
+   */
+  std::string segment_id_;
+
+  /**
+   * @brief Period (s) of the loop.
+   */
+  double period_s_;
+
+  /**
+   * @brief The states published to the other processes.
+   */
+  std::shared_ptr<SharedStateTimeseries> states_;
+
+  /**
+   * @brief The commands received from the other processes.
+   */
+  std::shared_ptr<SharedCommandTimeseries> commands_;
+
+  /**
+   * @brief This boolean makes sure that the loop is stopped upon destruction
+   * of this object.
+   */
+  bool is_loop_active_;
+
+  /**
+   * @brief The thread running the loop.
+   */
+  real_time_tools::RealTimeThread thread_;
+};
+
+/**
+ * @brief SharedMemoryClient attaches to the segments of a SharedMemoryBridge
+ * running in another process to read the states and send torque commands.
+ */
+class SharedMemoryClient {
+public:
+  /**
+   * @brief Construct a new SharedMemoryClient object. The bridge must be
+   * running.
+   *
+   * @param segment_id is the prefix of the shared memory segments.
+   */
+  SharedMemoryClient(const std::string &segment_id = "monopod");
+
+  /**
+   * @brief Read the newest state published by the bridge.
+   *
+   * @param state is filled with the newest state.
+   * @return bool false if no state was published yet.
+   */
+  bool read_state(StateSnapshot &state) const;
+
+  /**
+   * @brief Block until the bridge published a state newer than the last one
+   * read by wait_for_new_state().
+   *
+   * @param timeout_s is the maximum time to wait (s).
+   * @return bool true if a new state is available, false on timeout.
+   */
+  bool wait_for_new_state(const double &timeout_s = 0.01);
+
+  /**
+   * @brief Send torque targets to the Monopod. They are applied with
+   * Monopod::try_set_torque_targets, hence go through the same checks, and are
+   * dropped if the Monopod is not running.
+   *
+   * @param torque_targets vector of desired torque targets for indexed joints
+   * @param joint_indexes names of the joints we want to access
+   * @throw std::invalid_argument if the sizes differ or an index is not a
+   * JointNamesIndex.
+   */
+  void set_torque_targets(const Vector<double> &torque_targets,
+                          const Vector<int> &joint_indexes);
+
+private:
+  /**
+   * @brief The states published by the bridge.
+   */
+  std::shared_ptr<SharedStateTimeseries> states_;
+
+  /**
+   * @brief The commands applied by the bridge.
+   */
+  std::shared_ptr<SharedCommandTimeseries> commands_;
+
+  /**
+   * @brief Newest timeindex seen by wait_for_new_state().
+   */
+  Index state_timeindex_;
+};
+
+} // namespace monopod_drivers
@@ -2,36 +2,81 @@
 
 namespace monopod_drivers {
 CanBusControlBoards::CanBusControlBoards(
-    std::shared_ptr<CanBusInterface> can_bus, const size_t &history_length,
-    const int &control_timeout_ms)
-    : can_bus_(can_bus), active_boards_(board_count, false),
-      motors_are_paused_(false), control_timeout_ms_(control_timeout_ms) {
-  measurement_ = create_vector_of_pointers<ScalarTimeseries>(measurement_count,
-                                                             history_length);
+    std::shared_ptr<CanBusInterface> can_bus, const HistoryConfig &history,
+    const StreamingConfig &streaming, const int &control_timeout_ms)
+    : CanBusControlBoards({can_bus}, {0, 0, 0}, {}, history, streaming,
+                          control_timeout_ms) {}
 
-  status_ =
-      create_vector_of_pointers<StatusTimeseries>(board_count, history_length);
+CanBusControlBoards::CanBusControlBoards(
+    const Vector<std::shared_ptr<CanBusInterface>> &can_buses,
+    const std::array<int, board_count> &board_buses,
+    const Vector<ThreadPolicy> &decode_threads, const HistoryConfig &history,
+    const StreamingConfig &streaming, const int &control_timeout_ms)
+    : board_buses_(board_buses), recorder_(nullptr), decoded_frames_(0),
+      unknown_frames_(0), invalid_frames_(0), control_time_ns_(0),
+      active_boards_(board_count, false), streaming_(streaming),
+      motors_are_paused_(false), is_safemode_(false),
+      control_timeout_ms_(control_timeout_ms) {
+  history.validate();
+  for (auto &board_bus : board_buses_) {
+    if (board_bus < 0 || board_bus >= int(can_buses.size())) {
+      throw std::invalid_argument(
+          "every board must be mapped to one of the can buses.");
+    }
+  }
+  for (auto &can_bus : can_buses) {
+    buses_.push_back(std::make_unique<BusContext>());
+    buses_.back()->can_bus = can_bus;
+    buses_.back()->boards = this;
+    buses_.back()->index = buses_.size() - 1;
+    buses_.back()->frame_timestamp = 0;
+    buses_.back()->decoded_measurement_count = 0;
+    buses_.back()->decoded_status = -1;
+    // Only the newest current references are worth sending.
+    can_bus->set_transmit_coalescing({CanframeIDs::IqRef});
+  }
 
-  control_ = create_vector_of_pointers<ScalarTimeseries>(control_count,
-                                                         history_length);
+  measurement_.resize(measurement_count);
+  for (size_t i = 0; i < measurement_count; i++) {
+    if (streaming_.measurements[i]) {
+      measurement_[i] = std::make_shared<ScalarTimeseries>(
+          history.measurement_length, 0, false);
+    }
+  }
+
+  status_ = create_vector_of_pointers<StatusTimeseries>(
+      board_count, history.status_length);
 
-  command_ = std::make_shared<CommandTimeseries>(history_length, 0, false);
+  control_ = create_vector_of_pointers<ScalarTimeseries>(
+      control_count, history.control_length);
 
-  sent_control_ = create_vector_of_pointers<ScalarTimeseries>(control_count,
-                                                              history_length);
+  command_ =
+      std::make_shared<CommandTimeseries>(history.control_length, 0, false);
 
-  sent_command_ = std::make_shared<CommandTimeseries>(history_length, 0, false);
+  sent_control_ = create_vector_of_pointers<ScalarTimeseries>(
+      control_count, history.sent_length);
+
+  sent_command_ =
+      std::make_shared<CommandTimeseries>(history.sent_length, 0, false);
 
   // initialize board --------------------------------------------------------
   reset();
 
   is_loop_active_ = true;
-  rt_thread_.create_realtime_thread(&CanBusControlBoards::loop, this);
+  for (size_t i = 0; i < buses_.size(); i++) {
+    if (i < decode_threads.size()) {
+      decode_threads[i].apply(buses_[i]->thread);
+    }
+    buses_[i]->thread.create_realtime_thread(&CanBusControlBoards::loop,
+                                             buses_[i].get());
+  }
 }
 
 CanBusControlBoards::~CanBusControlBoards() {
   is_loop_active_ = false;
-  rt_thread_.join();
+  for (auto &bus : buses_) {
+    bus->thread.join();
+  }
   set_command(ControlBoardsCommand(ControlBoardsCommand::IDs::ENABLE_SYS,
                                    ControlBoardsCommand::Contents::DISABLE));
   send_newest_command();
@@ -52,11 +97,197 @@ void CanBusControlBoards::set_active_board(const int &index) {
     [[fallthrough]];
   case encoder_board1:
   case encoder_board2:
-    active_boards_[index] = true;
+    if (!active_boards_[index]) {
+      active_boards_[index] = true;
+      update_receive_filter();
+    }
     break;
   }
 }
 
+void CanBusControlBoards::update_receive_filter() {
+  for (size_t bus = 0; bus < buses_.size(); bus++) {
+    std::vector<can_id_t> can_ids;
+    if (active_boards_[motor_board] && board_buses_[motor_board] == int(bus)) {
+      can_ids.insert(can_ids.end(),
+                     {BOARD1_STATUSMSG, Iq, BOARD1_POS, BOARD1_VEL, BOARD1_ACC,
+                      BOARD1_ENC_INDEX, ADC6});
+    }
+    if (active_boards_[encoder_board1] &&
+        board_buses_[encoder_board1] == int(bus)) {
+      can_ids.insert(can_ids.end(), {BOARD2_STATUSMSG, BOARD2_POS, BOARD2_VEL,
+                                     BOARD2_ACC, BOARD2_ENC_INDEX});
+    }
+    if (active_boards_[encoder_board2] &&
+        board_buses_[encoder_board2] == int(bus)) {
+      can_ids.insert(can_ids.end(), {BOARD3_STATUSMSG, BOARD3_POS, BOARD3_VEL,
+                                     BOARD3_ACC, BOARD3_ENC_INDEX});
+    }
+    can_ids.erase(std::remove_if(can_ids.begin(), can_ids.end(),
+                                 [this](const can_id_t &can_id) {
+                                   return !is_frame_subscribed(can_id);
+                                 }),
+                  can_ids.end());
+    buses_[bus]->can_bus->set_receive_filter(can_ids);
+  }
+}
+
+bool CanBusControlBoards::is_frame_subscribed(const can_id_t &can_id) const {
+  if (can_id >= frame_decoder_count) {
+    return false;
+  }
+  const FrameDecoder &decoder = frame_decoders_[can_id];
+  switch (decoder.layout) {
+  case FrameLayout::ignored:
+    return false;
+  case FrameLayout::motor_board_status:
+  case FrameLayout::encoder_board_status:
+    return true;
+  default:
+    for (const auto &target : decoder.target) {
+      if (target >= 0 && streaming_.measurements[target]) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+ControlBoardsCommand::IDs
+CanBusControlBoards::get_stream_command(const int &index) {
+  switch (index) {
+  case current_0:
+  case current_1:
+    return ControlBoardsCommand::IDs::SEND_CURRENT;
+  case position_0:
+  case position_1:
+  case position_2:
+  case position_3:
+  case position_4:
+    return ControlBoardsCommand::IDs::SEND_POSITION;
+  case velocity_0:
+  case velocity_1:
+  case velocity_2:
+  case velocity_3:
+  case velocity_4:
+    return ControlBoardsCommand::IDs::SEND_VELOCITY;
+  case encoder_index_0:
+  case encoder_index_1:
+  case encoder_index_2:
+  case encoder_index_3:
+  case encoder_index_4:
+    return ControlBoardsCommand::IDs::SEND_ENC_INDEX;
+  case analog_0:
+  case analog_1:
+    return ControlBoardsCommand::IDs::SEND_ADC6;
+  default:
+    return ControlBoardsCommand::IDs::SEND_ALL;
+  }
+}
+
+void CanBusControlBoards::send_stream_commands() {
+  Vector<ControlBoardsCommand::IDs> commands;
+  for (size_t i = 0; i < measurement_count; i++) {
+    if (streaming_.measurements[i]) {
+      const ControlBoardsCommand::IDs command = get_stream_command(i);
+      if (std::find(commands.begin(), commands.end(), command) ==
+          commands.end()) {
+        commands.push_back(command);
+      }
+    }
+  }
+
+  // The commands are broadcast, so every board streams the union of what its
+  // measurements need. Start from nothing such that a previous subscription
+  // does not linger on the boards.
+  const bool is_sending_all =
+      std::find(commands.begin(), commands.end(),
+                ControlBoardsCommand::IDs::SEND_ALL) != commands.end();
+  set_command(ControlBoardsCommand(
+      ControlBoardsCommand::IDs::SEND_ALL,
+      is_sending_all ? ControlBoardsCommand::Contents::ENABLE
+                     : ControlBoardsCommand::Contents::DISABLE));
+  send_newest_command();
+  if (is_sending_all) {
+    return;
+  }
+  for (const auto &command : commands) {
+    set_command(
+        ControlBoardsCommand(command, ControlBoardsCommand::Contents::ENABLE));
+    send_newest_command();
+  }
+}
+
+void CanBusControlBoards::set_recorder(Ptr<TelemetryRecorder> recorder) {
+  // The loops only ever see the raw pointer, so the recorder is meant to be
+  // set once while initializing: replacing it drops the previous one.
+  recorder_.store(recorder.get(), std::memory_order_release);
+  recorder_owner_ = recorder;
+}
+
+void CanBusControlBoards::get_snapshot(BoardsSnapshot &snapshot) const {
+  if (buses_.size() == 1) {
+    buses_[0]->snapshot.load(snapshot);
+    return;
+  }
+
+  // Each board is decoded by the thread of its own bus, so the snapshot is
+  // merged from the data of every bus about the boards it owns.
+  BoardsSnapshot bus_snapshot;
+  snapshot.frame_count = 0;
+  snapshot.publish_time_ns = 0;
+  for (size_t bus = 0; bus < buses_.size(); bus++) {
+    buses_[bus]->snapshot.load(bus_snapshot);
+    for (size_t i = 0; i < measurement_count; i++) {
+      if (board_buses_[get_measurement_board(i)] == int(bus)) {
+        snapshot.measurements[i] = bus_snapshot.measurements[i];
+      }
+    }
+    for (size_t i = 0; i < board_count; i++) {
+      if (board_buses_[i] == int(bus)) {
+        snapshot.status[i] = bus_snapshot.status[i];
+      }
+    }
+    snapshot.frame_count += bus_snapshot.frame_count;
+    snapshot.publish_time_ns =
+        std::max(snapshot.publish_time_ns, bus_snapshot.publish_time_ns);
+  }
+}
+
+BoardsStats CanBusControlBoards::get_stats() const {
+  BoardsStats stats;
+  stats.decoded_frames = decoded_frames_.load(std::memory_order_relaxed);
+  stats.unknown_frames = unknown_frames_.load(std::memory_order_relaxed);
+  stats.invalid_frames = invalid_frames_.load(std::memory_order_relaxed);
+  stats.decode = decode_latency_.get_summary();
+  stats.control = control_latency_.get_summary();
+  for (const auto &bus : buses_) {
+    stats.can_buses.push_back(bus->can_bus->get_stats());
+  }
+  return stats;
+}
+
+int CanBusControlBoards::get_measurement_board(const int &index) {
+  switch (index) {
+  case position_2:
+  case position_3:
+  case velocity_2:
+  case velocity_3:
+  case acceleration_2:
+  case acceleration_3:
+  case encoder_index_2:
+  case encoder_index_3:
+    return encoder_board1;
+  case position_4:
+  case velocity_4:
+  case acceleration_4:
+  case encoder_index_4:
+    return encoder_board2;
+  default:
+    return motor_board;
+  }
+}
+
 void CanBusControlBoards::reset() {
 
   is_safemode_ = false;
@@ -66,9 +297,7 @@ void CanBusControlBoards::reset() {
                                    ControlBoardsCommand::Contents::ENABLE));
   send_newest_command();
 
-  set_command(ControlBoardsCommand(ControlBoardsCommand::IDs::SEND_ALL,
-                                   ControlBoardsCommand::Contents::ENABLE));
-  send_newest_command();
+  send_stream_commands();
 
   pause_motors();
 
@@ -105,60 +334,90 @@ void CanBusControlBoards::send_if_input_changed() {
   }
 }
 
-void CanBusControlBoards::wait_until_ready() {
+void CanBusControlBoards::wait_until_ready(const ReadinessConfig &config) {
+  if (!(config.timeout_s >= 0.0) || !(config.initial_retry_s > 0.0) ||
+      !(config.max_retry_s > 0.0) || !(config.backoff_factor >= 1.0)) {
+    throw std::invalid_argument("the readiness timeout and retry periods must "
+                                "be positive and the backoff at least 1.");
+  }
+  int board = get_not_ready_board();
+  if (board == board_count) {
+    return;
+  }
+
   rt_printf("waiting for boards and motors to be ready \n");
-  int timeout = 0;
-  while (!CanBusControlBoards::is_ready()) {
-    real_time_tools::Timer::sleep_sec(0.1);
-    CanBusControlBoards::reset();
-    timeout++;
-    if (timeout > 100) {
-      std::cerr
-          << "Timed out while waiting for boards to initialize. exiting. \n";
-      exit(-1);
+  const double start_s = real_time_tools::Timer::get_current_time_sec();
+  const double deadline_s = start_s + config.timeout_s;
+  double retry_s = config.initial_retry_s;
+  double next_reset_s = start_s;
+  while (board != board_count) {
+    const double now_s = real_time_tools::Timer::get_current_time_sec();
+    if (now_s >= deadline_s) {
+      Vector<int> silent_boards, not_ready_boards;
+      for (int i = 0; i < board_count; i++) {
+        if (!active_boards_[i]) {
+          continue;
+        }
+        if (status_[i]->length() == 0) {
+          silent_boards.push_back(i);
+        } else if (!status_[i]->newest_element().is_ready()) {
+          not_ready_boards.push_back(i);
+        }
+      }
+      BoardStatus motor_status = BoardStatus();
+      if (active_boards_[motor_board] && status_[motor_board]->length() > 0) {
+        motor_status = status_[motor_board]->newest_element();
+      }
+      throw BoardsNotReadyError(
+          silent_boards, not_ready_boards, motor_status.get_error_code(),
+          "timed out while waiting for the boards to be ready, motor board "
+          "error: '" +
+              motor_status.get_error_description() + "'.");
     }
+
+    // Only send the commands again if the boards did not get ready in time.
+    if (now_s >= next_reset_s) {
+      CanBusControlBoards::reset();
+      next_reset_s = now_s + retry_s;
+      retry_s = std::min(retry_s * config.backoff_factor, config.max_retry_s);
+    }
+
+    // Sleep until the board sends a new status or the next reset is due.
+    const Ptr<StatusTimeseries> &status = status_[board];
+    const Index next_status =
+        status->length() == 0 ? 0 : status->newest_timeindex(false) + 1;
+    status->wait_for_timeindex(next_status,
+                               std::min(next_reset_s, deadline_s) - now_s);
+    board = get_not_ready_board();
   }
   rt_printf("board and motors are ready \n");
 }
 
 bool CanBusControlBoards::is_ready() {
-  bool ready = true;
+  return get_not_ready_board() == board_count;
+}
+
+int CanBusControlBoards::get_not_ready_board() const {
   // if any of the boards have no status messages despite the board being active
   // then we are not ready. If the board is not active then we ignore it.
-  if (status_[motor_board]->length() == 0 && active_boards_[motor_board]) {
-    return false;
-  } else if (active_boards_[motor_board]) {
-    auto board = status_[motor_board]->newest_element();
-    ready = ready && board.is_ready();
-    if (board.get_error_code()) {
-      std::cerr << "Motor Board not ready because of '"
-                << board.get_error_description() << "'" << std::endl;
+  for (int i = 0; i < board_count; i++) {
+    if (active_boards_[i] && (status_[i]->length() == 0 ||
+                              !status_[i]->newest_element().is_ready())) {
+      return i;
     }
   }
-
-  if (status_[encoder_board1]->length() == 0 &&
-      active_boards_[encoder_board1]) {
-    return false;
-    // ready = ready && true;
-  } else if (active_boards_[encoder_board1]) {
-    ready = ready && status_[encoder_board1]->newest_element().is_ready();
-  }
-
-  if (status_[encoder_board2]->length() == 0 &&
-      active_boards_[encoder_board2]) {
-    return false;
-    // ready = ready && true;
-  } else if (active_boards_[encoder_board2]) {
-    ready = ready && status_[encoder_board2]->newest_element().is_ready();
-  }
-
-  return ready;
+  return board_count;
 }
 
 void CanBusControlBoards::pause_motors() {
   set_control(0, current_target_0);
   set_control(0, current_target_1);
-  send_newest_controls();
+  for (auto &control : control_) {
+    control->tag(control->newest_timeindex());
+  }
+  // The zeros are sent as such, a control set meanwhile by another thread
+  // must not go through.
+  send_controls({0.0, 0.0});
 
   disable_can_recv_timeout();
 
@@ -196,41 +455,25 @@ void CanBusControlBoards::send_newest_controls() {
     Index timeindex = control_[i]->newest_timeindex();
     controls[i] = (*control_[i])[timeindex];
     control_[i]->tag(timeindex);
+  }
+  send_controls(controls);
+}
 
+void CanBusControlBoards::send_controls(
+    const std::array<double, control_count> &controls) {
+  for (size_t i = 0; i < controls.size(); i++) {
     sent_control_[i]->append(controls[i]);
   }
 
-  float current_mtr1 = controls[0];
-  float current_mtr2 = controls[1];
-
-  uint8_t data[8];
-  uint32_t q_current1, q_current2;
-
-  // Convert floats to Q24 values
-  q_current1 = float_to_q24(current_mtr1);
-  q_current2 = float_to_q24(current_mtr2);
-
-  // Motor 1
-  data[0] = (q_current1 >> 24) & 0xFF;
-  data[1] = (q_current1 >> 16) & 0xFF;
-  data[2] = (q_current1 >> 8) & 0xFF;
-  data[3] = q_current1 & 0xFF;
-
-  // Motor 2
-  data[4] = (q_current2 >> 24) & 0xFF;
-  data[5] = (q_current2 >> 16) & 0xFF;
-  data[6] = (q_current2 >> 8) & 0xFF;
-  data[7] = q_current2 & 0xFF;
-
+  // Motor 1 in bytes 0 to 3, motor 2 in bytes 4 to 7.
   CanBusFrame can_frame;
   can_frame.id = CanframeIDs::IqRef;
-  for (size_t i = 0; i < 7; i++) {
-    can_frame.data[i] = data[i];
-  }
+  encode_q24_pair(controls[0], controls[1], can_frame.data.data());
   can_frame.dlc = 8;
 
-  can_bus_->set_input_frame(can_frame);
-  can_bus_->send_if_input_changed();
+  send_frame(can_frame, board_buses_[motor_board]);
+  control_latency_.record_since(
+      control_time_ns_.load(std::memory_order_relaxed));
 }
 
 void CanBusControlBoards::send_newest_command() {
@@ -244,42 +487,114 @@ void CanBusControlBoards::send_newest_command() {
   command_->tag(timeindex);
   sent_command_->append(command);
 
-  uint32_t id = command.id_;
-  int32_t content = command.content_;
+  // The content in bytes 0 to 3, the command in bytes 4 to 7.
+  CanBusFrame can_frame;
+  can_frame.id = CanframeIDs::COMMAND_ID;
+  encode_int32_pair(command.content_, command.id_, can_frame.data.data());
+  can_frame.dlc = 8;
 
-  uint8_t data[8];
+  broadcast_frame(can_frame);
+}
 
-  // content
-  data[0] = (content >> 24) & 0xFF;
-  data[1] = (content >> 16) & 0xFF;
-  data[2] = (content >> 8) & 0xFF;
-  data[3] = content & 0xFF;
+void CanBusControlBoards::send_frame(const CanBusFrame &can_frame,
+                                     const size_t &bus_index) {
+  BusContext &bus = *buses_[bus_index];
+  // The can bus only keeps the newest input frame, so two threads sending at
+  // the same time could overwrite each others frame before it is sent.
+  std::lock_guard<std::mutex> lock(bus.send_door);
+  bus.can_bus->set_input_frame(can_frame);
+  bus.can_bus->send_if_input_changed();
+
+  TelemetryRecorder *recorder = recorder_.load(std::memory_order_acquire);
+  if (recorder) {
+    recorder->record_frame(TelemetryRecord::SENT_FRAME, bus_index, can_frame);
+  }
+}
 
-  // command
-  data[4] = (id >> 24) & 0xFF;
-  data[5] = (id >> 16) & 0xFF;
-  data[6] = (id >> 8) & 0xFF;
-  data[7] = id & 0xFF;
+void CanBusControlBoards::broadcast_frame(const CanBusFrame &can_frame) {
+  // The commands are addressed to every board, whatever the bus it is on.
+  for (size_t i = 0; i < buses_.size(); i++) {
+    send_frame(can_frame, i);
+  }
+}
 
-  CanBusFrame can_frame;
-  can_frame.id = CanframeIDs::COMMAND_ID;
-  for (size_t i = 0; i < 8; i++) {
-    can_frame.data[i] = data[i];
+constexpr CanBusControlBoards::FrameDecoderTable
+CanBusControlBoards::make_frame_decoders() {
+  // The blmc cards send Q24 fixed-point values, the conversion to the unit of
+  // each measurement is folded into a single scale.
+  constexpr double q24 = q24_resolution;
+  // kilo-rotations into rad.
+  constexpr double position_scale = q24 * 2 * M_PI;
+  // kilo-rotations-per-minutes into rad/s.
+  constexpr double velocity_scale = q24 * 2 * M_PI * (1000. / 60.);
+  // TODO: check that the conversion here is proper for acceleration.
+  // kilo-rotations-per-minutes squared into rad/s^2.
+  constexpr double acceleration_scale = q24 * 2 * M_PI * (1000. / 60. / 60.);
+
+  FrameDecoderTable table = {};
+  for (auto &decoder : table) {
+    decoder = {FrameLayout::ignored, {-1, -1}, 0.0};
   }
-  can_frame.dlc = 8;
 
-  can_bus_->set_input_frame(can_frame);
-  can_bus_->send_if_input_changed();
+  table[Iq] = {FrameLayout::q24_pair, {current_0, current_1}, q24};
+  table[ADC6] = {FrameLayout::q24_pair, {analog_0, analog_1}, q24};
+
+  table[BOARD1_POS] = {
+      FrameLayout::q24_pair, {position_0, position_1}, position_scale};
+  table[BOARD2_POS] = {
+      FrameLayout::q24_pair, {position_2, position_3}, position_scale};
+  table[BOARD3_POS] = {FrameLayout::q24_single, {position_4, -1}, position_scale};
+
+  table[BOARD1_VEL] = {
+      FrameLayout::q24_pair, {velocity_0, velocity_1}, velocity_scale};
+  table[BOARD2_VEL] = {
+      FrameLayout::q24_pair, {velocity_2, velocity_3}, velocity_scale};
+  table[BOARD3_VEL] = {FrameLayout::q24_single, {velocity_4, -1}, velocity_scale};
+
+  table[BOARD1_ACC] = {FrameLayout::q24_pair,
+                       {acceleration_0, acceleration_1},
+                       acceleration_scale};
+  table[BOARD2_ACC] = {FrameLayout::q24_pair,
+                       {acceleration_2, acceleration_3},
+                       acceleration_scale};
+  table[BOARD3_ACC] = {
+      FrameLayout::q24_single, {acceleration_4, -1}, acceleration_scale};
+
+  table[BOARD1_ENC_INDEX] = {FrameLayout::encoder_index,
+                             {encoder_index_0, encoder_index_1},
+                             position_scale};
+  table[BOARD2_ENC_INDEX] = {FrameLayout::encoder_index,
+                             {encoder_index_2, encoder_index_3},
+                             position_scale};
+  table[BOARD3_ENC_INDEX] = {
+      FrameLayout::encoder_index, {encoder_index_4, -1}, position_scale};
+
+  table[BOARD1_STATUSMSG] = {
+      FrameLayout::motor_board_status, {motor_board, -1}, 0.0};
+  table[BOARD2_STATUSMSG] = {
+      FrameLayout::encoder_board_status, {encoder_board1, -1}, 0.0};
+  table[BOARD3_STATUSMSG] = {
+      FrameLayout::encoder_board_status, {encoder_board2, -1}, 0.0};
+
+  return table;
 }
 
-void CanBusControlBoards::loop() {
+const CanBusControlBoards::FrameDecoderTable
+    CanBusControlBoards::frame_decoders_ =
+        CanBusControlBoards::make_frame_decoders();
+
+void CanBusControlBoards::loop(BusContext &bus) {
+  // make sure the decoder table is generated at compile time.
+  static_assert(make_frame_decoders()[BOARD1_POS].layout ==
+                    FrameLayout::q24_pair,
+                "the frame decoders must be a constant expression");
 
   // receive data from board in a loop ---------------------------------------
-  long int timeindex = can_bus_->get_output_frame()->newest_timeindex();
+  long int timeindex = bus.can_bus->get_output_frame()->newest_timeindex();
   while (is_loop_active_) {
     CanBusFrame can_frame;
     Index received_timeindex = timeindex;
-    can_frame = (*can_bus_->get_output_frame())[received_timeindex];
+    can_frame = (*bus.can_bus->get_output_frame())[received_timeindex];
 
     if (received_timeindex != timeindex) {
       rt_printf("did not get the timeindex we expected! "
@@ -291,112 +606,56 @@ void CanBusControlBoards::loop() {
 
     timeindex++;
 
-    // convert to measurement ------------------------------------------
-    double measurement_0 = qbytes_to_float(can_frame.data.begin());
-    double measurement_1 = qbytes_to_float((can_frame.data.begin() + 4));
-
-    switch (can_frame.id) {
-    case CanframeIDs::Iq:
-      measurement_[current_0]->append(measurement_0);
-      measurement_[current_1]->append(measurement_1);
-      break;
-
-    case CanframeIDs::BOARD1_POS:
-      // Convert the position unit from the blmc card (kilo-rotations)
-      // into rad.
-      measurement_[position_0]->append(measurement_0 * 2 * M_PI);
-      measurement_[position_1]->append(measurement_1 * 2 * M_PI);
-      break;
-
-    case CanframeIDs::BOARD2_POS:
-      // Convert the position unit from the blmc card (kilo-rotations)
-      // into rad.
-      measurement_[position_2]->append(measurement_0 * 2 * M_PI);
-      measurement_[position_3]->append(measurement_1 * 2 * M_PI);
-      break;
-
-    case CanframeIDs::BOARD3_POS:
-      // Convert the position unit from the blmc card (kilo-rotations)
-      // into rad.
-      measurement_[position_4]->append(measurement_0 * 2 * M_PI);
-      break;
-
-    case CanframeIDs::BOARD1_VEL:
-      // Convert the speed unit from the blmc card
-      // (kilo-rotations-per-minutes) into rad/s.
-      measurement_[velocity_0]->append(measurement_0 * 2 * M_PI *
-                                       (1000. / 60.));
-      measurement_[velocity_1]->append(measurement_1 * 2 * M_PI *
-                                       (1000. / 60.));
-      break;
-
-    case CanframeIDs::BOARD2_VEL:
-      // Convert the speed unit from the blmc card
-      // (kilo-rotations-per-minutes) into rad/s.
-      measurement_[velocity_2]->append(measurement_0 * 2 * M_PI *
-                                       (1000. / 60.));
-      measurement_[velocity_3]->append(measurement_1 * 2 * M_PI *
-                                       (1000. / 60.));
-      break;
-
-    case CanframeIDs::BOARD3_VEL:
-      // Convert the speed unit from the blmc card
-      // (kilo-rotations-per-minutes) into rad/s.
-      measurement_[velocity_4]->append(measurement_0 * 2 * M_PI *
-                                       (1000. / 60.));
-      break;
-
-    case CanframeIDs::BOARD1_ACC:
-      // TODO: check that the conversion here is proper for acceleration.
-      // Convert the acceleration unit from the blmc card
-      // (kilo-rotations-per-minutes squared) into rad/s^2.
-      measurement_[acceleration_0]->append(measurement_0 * 2 * M_PI *
-                                           (1000. / 60. / 60.));
-      measurement_[acceleration_1]->append(measurement_1 * 2 * M_PI *
-                                           (1000. / 60. / 60.));
-      break;
-
-    case CanframeIDs::BOARD2_ACC:
-      // TODO: put proper units for acceleration here
-      // Convert the acceleration unit from the blmc card
-      // (kilo-rotations-per-minutessquared) into rad/s^2.
-      measurement_[acceleration_2]->append(measurement_0 * 2 * M_PI *
-                                           (1000. / 60. / 60.));
-      measurement_[acceleration_3]->append(measurement_1 * 2 * M_PI *
-                                           (1000. / 60. / 60.));
-      break;
+    TelemetryRecorder *recorder = recorder_.load(std::memory_order_acquire);
+    if (recorder) {
+      recorder->record_frame(TelemetryRecord::RECEIVED_FRAME, bus.index,
+                             can_frame);
+    }
+    bus.frame_timestamp = can_frame.timestamp;
 
-    case CanframeIDs::BOARD3_ACC:
-      // TODO: put proper units for acceleration here
-      // Convert the acceleration unit from the blmc card
-      // (kilo-rotations-per-minutes squared) into rad/s^2.
-      measurement_[acceleration_4]->append(measurement_0 * 2 * M_PI *
-                                           (1000. / 60. / 60.));
+    // decode the frame ------------------------------------------------
+    if (can_frame.id >= frame_decoder_count) {
+      unknown_frames_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    const FrameDecoder &decoder = frame_decoders_[can_frame.id];
+
+    switch (decoder.layout) {
+    case FrameLayout::ignored:
+      unknown_frames_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+
+    case FrameLayout::q24_pair: {
+      int32_t first, second;
+      decode_int32_pair(can_frame.data.data(), first, second);
+      // The first channel of a pair is the one Monopod waits on (e.g.
+      // position_0), so it is appended last for the pair to be complete in
+      // the histories when the waiting threads wake up.
+      append_measurement(bus, decoder.target[1], decoder.scale * second);
+      append_measurement(bus, decoder.target[0], decoder.scale * first);
       break;
+    }
 
-    case CanframeIDs::ADC6:
-      measurement_[analog_0]->append(measurement_0);
-      measurement_[analog_1]->append(measurement_1);
+    case FrameLayout::q24_single:
+      append_measurement(bus, decoder.target[0],
+                         decoder.scale * decode_int32(can_frame.data.data()));
       break;
 
-    case CanframeIDs::BOARD1_ENC_INDEX: {
+    case FrameLayout::encoder_index: {
       // here the interpretation of the message is different,
-      // we get a motor index and a measurement
+      // we get a motor index and a measurement. The frame is dropped if the
+      // board has no such motor.
       uint8_t motor_index = can_frame.data[4];
-      if (motor_index == 0) {
-        measurement_[encoder_index_0]->append(measurement_0 * 2 * M_PI);
-      } else if (motor_index == 1) {
-        measurement_[encoder_index_1]->append(measurement_0 * 2 * M_PI);
-      } else {
-        rt_printf("ERROR: Invalid motor number"
-                  "for encoder index: %d\n",
-                  motor_index);
-        exit(-1);
+      if (motor_index > 1 || decoder.target[motor_index] < 0) {
+        invalid_frames_.fetch_add(1, std::memory_order_relaxed);
+        continue;
       }
+      append_measurement(bus, decoder.target[motor_index],
+                         decoder.scale * decode_int32(can_frame.data.data()));
       break;
     }
 
-    case CanframeIDs::BOARD1_STATUSMSG: {
+    case FrameLayout::motor_board_status: {
       BoardStatus status;
       uint8_t data = can_frame.data[0];
       status.system_enabled = data >> 0;
@@ -406,7 +665,7 @@ void CanBusControlBoards::loop() {
       status.motor2_ready = data >> 4;
       status.error_code = data >> 5;
 
-      status_[motor_board]->append(status);
+      append_status(bus, decoder.target[0], status);
 
       if (status.get_error_code() == status.ErrorCodes::ENCODER) {
         std::cerr << "Encoder Error Encountered. This is a terminal issue and "
@@ -414,11 +673,10 @@ void CanBusControlBoards::loop() {
                   << std::endl;
         exit(-1);
       }
-
       break;
     }
 
-    case CanframeIDs::BOARD2_STATUSMSG: {
+    case FrameLayout::encoder_board_status: {
       BoardStatus status;
       status.system_enabled = 1;
       status.motor1_enabled = 1;
@@ -427,23 +685,18 @@ void CanBusControlBoards::loop() {
       status.motor2_ready = 1;
       status.error_code = 0;
 
-      status_[encoder_board1]->append(status);
-      break;
-    }
-
-    case CanframeIDs::BOARD3_STATUSMSG: {
-      BoardStatus status;
-      status.system_enabled = 1;
-      status.motor1_enabled = 1;
-      status.motor1_ready = 1;
-      status.motor2_enabled = 1;
-      status.motor2_ready = 1;
-      status.error_code = 0;
-
-      status_[encoder_board2]->append(status);
+      append_status(bus, decoder.target[0], status);
       break;
     }
     }
+
+    // publish the newest data ------------------------------------------
+    bus.decoded.frame_count++;
+    bus.decoded.publish_time_ns = get_wall_time_ns();
+    bus.snapshot.store(bus.decoded);
+    append_decoded(bus);
+    decoded_frames_.fetch_add(1, std::memory_order_relaxed);
+    decode_latency_.record_since(can_frame.timestamp);
   }
 }
 
@@ -452,7 +705,7 @@ void CanBusControlBoards::print_status() {
   rt_printf("measurements: -------------------------------\n");
   for (size_t i = 0; i < measurement_.size(); i++) {
     rt_printf("%d: ---------------------------------\n", int(i));
-    if (measurement_[i]->length() > 0) {
+    if (measurement_[i] && measurement_[i]->length() > 0) {
       double measurement = measurement_[i]->newest_element();
       rt_printf("value %f:\n", measurement);
     }
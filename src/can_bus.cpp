@@ -1,11 +1,29 @@
-
+#include <algorithm>
+#include <chrono>
 #include <sstream>
+#include <stdexcept>
 
 #include "monopod_sdk/monopod_drivers/devices/can_bus.hpp"
 
 namespace monopod_drivers {
 CanBus::CanBus(const std::string &can_interface_name,
-               const size_t &history_length) {
+               const size_t &history_length,
+               const ThreadPolicy &receive_thread,
+               const CanBusTransmitConfig &transmit)
+    : received_frames_(0), sent_frames_(0), send_retries_(0),
+      dropped_frames_(0), transmit_(transmit),
+      command_queue_(transmit.queue_capacity),
+      control_queue_(transmit.queue_capacity), queued_frames_(0),
+      coalesced_frames_(0), rejected_frames_(0), next_transmit_s_(0.0),
+      is_transmit_waiting_(false), is_transmit_active_(false) {
+  if (transmit_.bitrate < 0.0) {
+    throw std::invalid_argument("the bitrate of the CAN bus must be positive.");
+  }
+  for (auto &is_coalesced : is_coalesced_) {
+    is_coalesced = false;
+  }
+  pending_controls_.reserve(transmit_.queue_capacity);
+
   input_ = std::make_shared<CanframeTimeseries>(history_length, 0, false);
   sent_input_ = std::make_shared<CanframeTimeseries>(history_length, 0, false);
   output_ = std::make_shared<CanframeTimeseries>(history_length, 0, false);
@@ -14,10 +32,27 @@ CanBus::CanBus(const std::string &can_interface_name,
   can_connection_.set(setup_can(can_interface_name, 0));
 
   is_loop_active_ = true;
+  receive_thread.apply(rt_thread_);
   rt_thread_.create_realtime_thread(&CanBus::loop, this);
+
+  if (transmit_.asynchronous) {
+    is_transmit_active_ = true;
+    transmit_.thread.apply(transmit_thread_);
+    transmit_thread_.create_realtime_thread(&CanBus::transmit_loop, this);
+  }
 }
 
 CanBus::~CanBus() {
+  // The sender goes first such that the frames queued last, e.g. the
+  // disabling of the boards, still reach the network.
+  if (transmit_.asynchronous) {
+    is_transmit_active_ = false;
+    {
+      std::lock_guard<std::mutex> lock(transmit_door_);
+      transmit_condition_.notify_one();
+    }
+    transmit_thread_.join();
+  }
   is_loop_active_ = false;
   rt_thread_.join();
   osi::close_can_device(can_connection_.get().socket);
@@ -27,16 +62,165 @@ void CanBus::send_if_input_changed() {
   if (input_->has_changed_since_tag()) {
     time_series::Index timeindex_to_send = input_->newest_timeindex();
     CanBusFrame frame_to_send = (*input_)[timeindex_to_send];
+
+    if (transmit_.asynchronous) {
+      if (queue_frame(frame_to_send)) {
+        input_->tag(timeindex_to_send);
+      } else {
+        rejected_frames_.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
     input_->tag(timeindex_to_send);
     sent_input_->append(frame_to_send);
-
     send_frame(frame_to_send);
   }
 }
 
+void CanBus::set_transmit_coalescing(const std::vector<can_id_t> &can_ids) {
+  for (auto &is_coalesced : is_coalesced_) {
+    is_coalesced = false;
+  }
+  for (const auto &can_id : can_ids) {
+    is_coalesced_[can_id & CAN_SFF_MASK] = true;
+  }
+}
+
+void CanBus::set_receive_filter(const std::vector<can_id_t> &can_ids) {
+  int socket = can_connection_.get().socket;
+
+  std::vector<struct can_filter> filters(can_ids.size());
+  for (size_t i = 0; i < can_ids.size(); i++) {
+    // The flags are compared as well, such that only the standard data frames
+    // with exactly this id pass.
+    filters[i].can_id = can_ids[i] & CAN_SFF_MASK;
+    filters[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+  }
+
+  int ret = rt_dev_setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FILTER,
+                              filters.data(),
+                              filters.size() * sizeof(struct can_filter));
+  if (ret < 0) {
+    rt_fprintf(stderr, "rt_dev_setsockopt CAN_RAW_FILTER: %s\n",
+               strerror(errno));
+    rt_printf("Couldn't set the CAN receive filter, receiving all frames.\n");
+  }
+}
+
+CanBusStats CanBus::get_stats() const {
+  CanBusStats stats;
+  stats.received_frames = received_frames_.load(std::memory_order_relaxed);
+  stats.sent_frames = sent_frames_.load(std::memory_order_relaxed);
+  stats.send_retries = send_retries_.load(std::memory_order_relaxed);
+  stats.dropped_frames = dropped_frames_.load(std::memory_order_relaxed);
+  stats.coalesced_frames = coalesced_frames_.load(std::memory_order_relaxed);
+  stats.rejected_frames = rejected_frames_.load(std::memory_order_relaxed);
+  stats.receive = receive_latency_.get_summary();
+  stats.send = send_latency_.get_summary();
+  return stats;
+}
+
 void CanBus::loop() {
+  std::array<CanBusFrame, receive_batch_size> frames;
   while (is_loop_active_) {
-    output_->append(receive_frame());
+    size_t frame_count = receive_frames(frames);
+    for (size_t i = 0; i < frame_count; i++) {
+      output_->append(frames[i]);
+      receive_latency_.record_since(frames[i].timestamp);
+    }
+    received_frames_.fetch_add(frame_count, std::memory_order_relaxed);
+  }
+}
+
+bool CanBus::queue_frame(const CanBusFrame &frame) {
+  if (is_coalesced_[frame.id & CAN_SFF_MASK]) {
+    // The newest control matters, drop the oldest one if the sender lags.
+    CanBusFrame superseded;
+    while (!control_queue_.try_push(frame)) {
+      if (control_queue_.try_pop(superseded)) {
+        queued_frames_.fetch_sub(1);
+        coalesced_frames_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  } else if (!command_queue_.try_push(frame)) {
+    // The commands are never dropped silently, the queue is only full if the
+    // bus is down and the sender must not wait for it.
+    return false;
+  }
+
+  queued_frames_.fetch_add(1);
+  if (is_transmit_waiting_) {
+    std::lock_guard<std::mutex> lock(transmit_door_);
+    transmit_condition_.notify_one();
+  }
+  return true;
+}
+
+/**
+ * @brief Get the number of bits a classic CAN frame with a standard id takes
+ * on the bus, including the worst case number of stuff bits.
+ *
+ * @param dlc is the number of data bytes.
+ * @return size_t
+ */
+static size_t get_frame_bits(const uint8_t &dlc) {
+  // 34 bits are subject to stuffing besides the data, 13 are not.
+  const size_t stuffed_bits = 34 + 8 * dlc;
+  return stuffed_bits + 13 + (stuffed_bits - 1) / 4;
+}
+
+void CanBus::transmit_frame(const CanBusFrame &frame) {
+  if (transmit_.bitrate > 0.0) {
+    double now_s = real_time_tools::Timer::get_current_time_sec();
+    if (next_transmit_s_ > now_s) {
+      real_time_tools::Timer::sleep_until_sec(next_transmit_s_);
+      now_s = next_transmit_s_;
+    }
+    next_transmit_s_ = now_s + get_frame_bits(frame.dlc) / transmit_.bitrate;
+  }
+  send_frame(frame);
+  sent_input_->append(frame);
+}
+
+void CanBus::transmit_loop() {
+  CanBusFrame frame;
+  while (is_transmit_active_ || queued_frames_ > 0) {
+    // The commands first, in order.
+    while (command_queue_.try_pop(frame)) {
+      queued_frames_.fetch_sub(1);
+      transmit_frame(frame);
+    }
+
+    // Then the newest control of each id.
+    pending_controls_.clear();
+    for (size_t i = 0;
+         i < control_queue_.capacity() && control_queue_.try_pop(frame); i++) {
+      queued_frames_.fetch_sub(1);
+      auto pending =
+          std::find_if(pending_controls_.begin(), pending_controls_.end(),
+                       [&frame](const CanBusFrame &pending_control) {
+                         return pending_control.id == frame.id;
+                       });
+      if (pending == pending_controls_.end()) {
+        pending_controls_.push_back(frame);
+      } else {
+        *pending = frame;
+        coalesced_frames_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    for (const auto &control : pending_controls_) {
+      transmit_frame(control);
+    }
+
+    if (queued_frames_ == 0 && is_transmit_active_) {
+      std::unique_lock<std::mutex> lock(transmit_door_);
+      is_transmit_waiting_ = true;
+      if (queued_frames_ == 0 && is_transmit_active_) {
+        // The timeout bounds the wait should a notification be missed.
+        transmit_condition_.wait_for(lock, std::chrono::milliseconds(1));
+      }
+      is_transmit_waiting_ = false;
+    }
   }
 }
 
@@ -56,8 +240,13 @@ void CanBus::send_frame(const CanBusFrame &unstamped_can_frame) {
          unstamped_can_frame.dlc);
 
   // send ----------------------------------------------------------------
-  osi::send_to_can_device(socket, (void *)&can_frame, sizeof(can_frame_t), 0,
-                          (struct sockaddr *)&address, sizeof(address));
+  const uint64_t start_ns = get_wall_time_ns();
+  size_t retries = osi::send_to_can_device(
+      socket, (void *)&can_frame, sizeof(can_frame_t), 0,
+      (struct sockaddr *)&address, sizeof(address));
+  send_latency_.record_since(start_ns);
+  send_retries_.fetch_add(retries, std::memory_order_relaxed);
+  sent_frames_.fetch_add(1, std::memory_order_relaxed);
 }
 
 CanBusFrame CanBus::receive_frame() {
@@ -94,6 +283,7 @@ CanBusFrame CanBus::receive_frame() {
   CanBusFrame out_frame;
   out_frame.id = can_frame.can_id;
   out_frame.dlc = can_frame.can_dlc;
+  out_frame.timestamp = timestamp;
   for (size_t i = 0; i < can_frame.can_dlc; i++) {
     out_frame.data[i] = can_frame.data[i];
   }
@@ -101,6 +291,122 @@ CanBusFrame CanBus::receive_frame() {
   return out_frame;
 }
 
+#ifndef __XENO__
+/**
+ * @brief Get the timestamps of a received message from its control messages.
+ *
+ * @param message_header is the header of the received message.
+ * @param timestamp is set to the software timestamp (ns) taken on the wall
+ * clock, 0 if none is available.
+ * @param hardware_timestamp is set to the raw hardware timestamp (ns) taken on
+ * the clock of the CAN device, 0 if none is available.
+ */
+static void read_timestamps(struct msghdr &message_header,
+                            nanosecs_abs_t &timestamp,
+                            nanosecs_abs_t &hardware_timestamp) {
+  timestamp = 0;
+  hardware_timestamp = 0;
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message_header); cmsg != NULL;
+       cmsg = CMSG_NXTHDR(&message_header, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET) {
+      continue;
+    }
+    if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+      struct scm_timestamping stamps;
+      memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+      // ts[0] is the software timestamp and ts[2] the raw hardware one. The
+      // latter counts on the clock of the CAN controller, it cannot be
+      // compared to the host time.
+      timestamp = stamps.ts[0].tv_sec * 1000000000ULL + stamps.ts[0].tv_nsec;
+      hardware_timestamp =
+          stamps.ts[2].tv_sec * 1000000000ULL + stamps.ts[2].tv_nsec;
+      return;
+    }
+    if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec stamp;
+      memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+      timestamp = stamp.tv_sec * 1000000000ULL + stamp.tv_nsec;
+    }
+  }
+}
+
+/**
+ * @brief Get the number of frames dropped by the kernel since the socket was
+ * opened, see SO_RXQ_OVFL.
+ *
+ * @param message_header is the header of the received message.
+ * @param drop_count is set to the count if the message reports it.
+ * @return bool true if the message reports the count.
+ */
+static bool read_drop_count(struct msghdr &message_header,
+                            uint32_t &drop_count) {
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message_header); cmsg != NULL;
+       cmsg = CMSG_NXTHDR(&message_header, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+      memcpy(&drop_count, CMSG_DATA(cmsg), sizeof(drop_count));
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+size_t
+CanBus::receive_frames(std::array<CanBusFrame, receive_batch_size> &frames) {
+#ifdef __XENO__
+  frames[0] = receive_frame();
+  return 1;
+#else
+  int socket = can_connection_.get().socket;
+
+  // data we want to obtain ----------------------------------------------
+  can_frame_t can_frames[receive_batch_size];
+  char control[receive_batch_size]
+              [CMSG_SPACE(sizeof(struct scm_timestamping)) +
+               CMSG_SPACE(sizeof(struct timespec)) +
+               CMSG_SPACE(sizeof(uint32_t))];
+  struct iovec input_output_vectors[receive_batch_size];
+  struct mmsghdr message_headers[receive_batch_size];
+
+  // setup messages such that data can be received to variables above ----
+  memset(message_headers, 0, sizeof(message_headers));
+  for (size_t i = 0; i < receive_batch_size; i++) {
+    input_output_vectors[i].iov_base = (void *)&can_frames[i];
+    input_output_vectors[i].iov_len = sizeof(can_frame_t);
+
+    message_headers[i].msg_hdr.msg_iov = &input_output_vectors[i];
+    message_headers[i].msg_hdr.msg_iovlen = 1;
+    message_headers[i].msg_hdr.msg_control = (void *)control[i];
+    message_headers[i].msg_hdr.msg_controllen = sizeof(control[i]);
+  }
+
+  // receive messages from can bus ---------------------------------------
+  unsigned int message_count = osi::receive_messages_from_can_device(
+      socket, message_headers, receive_batch_size);
+
+  // process received data and put into felix widmaier's format ----------
+  for (unsigned int i = 0; i < message_count; i++) {
+    CanBusFrame &out_frame = frames[i];
+    out_frame.id = can_frames[i].can_id;
+    out_frame.dlc = can_frames[i].can_dlc;
+    read_timestamps(message_headers[i].msg_hdr, out_frame.timestamp,
+                    out_frame.hardware_timestamp);
+    for (size_t j = 0; j < can_frames[i].can_dlc; j++) {
+      out_frame.data[j] = can_frames[i].data[j];
+    }
+  }
+
+  uint32_t drop_count;
+  if (message_count > 0 &&
+      read_drop_count(message_headers[message_count - 1].msg_hdr,
+                      drop_count)) {
+    dropped_frames_.store(drop_count, std::memory_order_relaxed);
+  }
+
+  return message_count;
+#endif
+}
+
 CanBusConnection CanBus::setup_can(std::string name, uint32_t err_mask) {
   int socket_number;
   sockaddr_can recv_addr;
@@ -159,8 +465,32 @@ CanBusConnection CanBus::setup_can(std::string name, uint32_t err_mask) {
     rt_printf("Couldn't setup CAN connection. Exit.");
     exit(-1);
   }
-#elif defined RT_PREEMPT
-  // TODO: Need to support timestamps.
+#else
+  // Enable the software timestamps of the kernel for frames, and the
+  // hardware ones as well if the device supports it.
+  int timestamping_flags =
+      SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+      SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+  ret = rt_dev_setsockopt(socket_number, SOL_SOCKET, SO_TIMESTAMPING,
+                          &timestamping_flags, sizeof(timestamping_flags));
+  if (ret < 0) {
+    int enable_timestamps = 1;
+    ret = rt_dev_setsockopt(socket_number, SOL_SOCKET, SO_TIMESTAMPNS,
+                            &enable_timestamps, sizeof(enable_timestamps));
+  }
+  if (ret < 0) {
+    rt_printf("WARNING: CAN frames will not be timestamped (%s).\n",
+              strerror(errno));
+  }
+
+  // Have the kernel report the frames it drops when the socket is full.
+  int enable_drop_count = 1;
+  ret = rt_dev_setsockopt(socket_number, SOL_SOCKET, SO_RXQ_OVFL,
+                          &enable_drop_count, sizeof(enable_drop_count));
+  if (ret < 0) {
+    rt_printf("WARNING: dropped CAN frames will not be counted (%s).\n",
+              strerror(errno));
+  }
 #endif
 
   // TODO why the memset?
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "monopod_sdk/monopod_drivers/devices/can_bus_replay.hpp"
+#include "monopod_sdk/monopod_drivers/devices/telemetry_recorder.hpp"
+
+namespace monopod_drivers {
+
+CanBusReplay::CanBusReplay(const Vector<CanBusFrame> &frames,
+                           const double &speed, const size_t &history_length)
+    : frames_(frames), speed_(speed), received_frames_(0), sent_frames_(0),
+      is_started_(false), is_done_(false), is_loop_active_(false),
+      is_filtering_(false) {
+  if (!(speed_ >= 0.0)) {
+    throw std::invalid_argument("the replay speed must be positive.");
+  }
+  const size_t length =
+      history_length > 0 ? history_length : std::max<size_t>(frames_.size(), 1);
+  input_ = std::make_shared<CanframeTimeseries>(length, 0, false);
+  sent_input_ = std::make_shared<CanframeTimeseries>(length, 0, false);
+  output_ = std::make_shared<CanframeTimeseries>(length, 0, false);
+
+  for (auto &is_received : is_received_) {
+    is_received = true;
+  }
+}
+
+CanBusReplay::CanBusReplay(const std::string &log_file, const double &speed,
+                           const size_t &history_length)
+    : CanBusReplay(load(log_file), speed, history_length) {}
+
+CanBusReplay::~CanBusReplay() {
+  if (is_started_) {
+    is_loop_active_ = false;
+    rt_thread_.join();
+  }
+}
+
+Vector<CanBusFrame> CanBusReplay::load(const std::string &log_file) {
+  std::ifstream file(log_file, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("cannot open the CAN log " + log_file + ".");
+  }
+  TelemetryFileHeader header;
+  char magic[sizeof(header.magic)] = {};
+  file.read(magic, sizeof(magic));
+  if (file && std::memcmp(magic, header.magic, sizeof(magic)) == 0) {
+    return load_telemetry(log_file);
+  }
+  return load_candump(log_file);
+}
+
+/**
+ * @brief Convert one hexadecimal digit.
+ *
+ * @param digit
+ * @return int the value of the digit, -1 if it is not one.
+ */
+static int hex_to_int(const char &digit) {
+  if (digit >= '0' && digit <= '9') {
+    return digit - '0';
+  }
+  if (digit >= 'a' && digit <= 'f') {
+    return digit - 'a' + 10;
+  }
+  if (digit >= 'A' && digit <= 'F') {
+    return digit - 'A' + 10;
+  }
+  return -1;
+}
+
+Vector<CanBusFrame>
+CanBusReplay::load_candump(const std::string &log_file,
+                           const std::string &interface_name) {
+  std::ifstream file(log_file);
+  if (!file) {
+    throw std::runtime_error("cannot open the CAN log " + log_file + ".");
+  }
+
+  Vector<CanBusFrame> frames;
+  std::string line;
+  while (std::getline(file, line)) {
+    // (seconds.microseconds) interface id#data
+    std::istringstream fields(line);
+    std::string time, name, content;
+    if (!(fields >> time >> name >> content) || time.size() < 3 ||
+        time.front() != '(' || time.back() != ')') {
+      continue;
+    }
+    if (!interface_name.empty() && name != interface_name) {
+      continue;
+    }
+
+    const size_t separator = content.find('#');
+    if (separator == std::string::npos || separator == 0 ||
+        content.find('#', separator + 1) != std::string::npos) {
+      // Not a classic data frame, e.g. a CAN FD one.
+      continue;
+    }
+    const std::string data = content.substr(separator + 1);
+    if (data.size() % 2 != 0 || data.size() > 16) {
+      // Remote requests and malformed payloads.
+      continue;
+    }
+
+    CanBusFrame frame;
+    try {
+      frame.id = std::stoul(content.substr(0, separator), nullptr, 16);
+      // The 3 digits ids are standard ones, the 8 digits extended ones.
+      if (separator > 3) {
+        frame.id |= CAN_EFF_FLAG;
+      }
+
+      const std::string stamp = time.substr(1, time.size() - 2);
+      const size_t dot = stamp.find('.');
+      uint64_t seconds = std::stoull(stamp.substr(0, dot));
+      uint64_t nanoseconds = 0;
+      if (dot != std::string::npos) {
+        std::string fraction = stamp.substr(dot + 1, 9);
+        fraction.resize(9, '0');
+        nanoseconds = std::stoull(fraction);
+      }
+      frame.timestamp = seconds * 1000000000ULL + nanoseconds;
+    } catch (const std::exception &) {
+      continue;
+    }
+
+    frame.dlc = data.size() / 2;
+    frame.data.fill(0);
+    bool is_valid = true;
+    for (size_t i = 0; i < frame.dlc; i++) {
+      const int high = hex_to_int(data[2 * i]);
+      const int low = hex_to_int(data[2 * i + 1]);
+      is_valid = is_valid && high >= 0 && low >= 0;
+      frame.data[i] = (high << 4) | low;
+    }
+    if (is_valid) {
+      frames.push_back(frame);
+    }
+  }
+  return frames;
+}
+
+Vector<CanBusFrame> CanBusReplay::load_telemetry(const std::string &log_file,
+                                                 const int &bus) {
+  std::ifstream file(log_file, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("cannot open the telemetry file " + log_file +
+                             ".");
+  }
+
+  const TelemetryFileHeader expected;
+  TelemetryFileHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file ||
+      std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+      header.version != expected.version ||
+      header.record_size != expected.record_size) {
+    throw std::runtime_error(log_file + " is not a telemetry file.");
+  }
+
+  Vector<CanBusFrame> frames;
+  TelemetryRecord record;
+  while (file.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+    if (record.kind != TelemetryRecord::RECEIVED_FRAME ||
+        (bus >= 0 && record.channel != bus)) {
+      continue;
+    }
+    CanBusFrame frame;
+    frame.id = record.can_id;
+    frame.dlc = std::min<uint8_t>(record.dlc, frame.data.size());
+    std::memcpy(frame.data.data(), record.data, frame.data.size());
+    // Every received frame has a host time, the device timestamp is missing
+    // on the interfaces which do not support it.
+    frame.timestamp = record.host_time_ns;
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+void CanBusReplay::start() {
+  if (is_started_) {
+    return;
+  }
+  is_started_ = true;
+  is_loop_active_ = true;
+  rt_thread_.create_realtime_thread(&CanBusReplay::loop, this);
+}
+
+CanBusStats CanBusReplay::get_stats() const {
+  CanBusStats stats;
+  stats.received_frames = received_frames_.load(std::memory_order_relaxed);
+  stats.sent_frames = sent_frames_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CanBusReplay::set_receive_filter(const std::vector<can_id_t> &can_ids) {
+  for (auto &is_received : is_received_) {
+    is_received = false;
+  }
+  for (const auto &can_id : can_ids) {
+    is_received_[can_id & CAN_SFF_MASK] = true;
+  }
+  is_filtering_ = true;
+}
+
+void CanBusReplay::send_if_input_changed() {
+  if (input_->has_changed_since_tag()) {
+    time_series::Index timeindex_to_send = input_->newest_timeindex();
+    input_->tag(timeindex_to_send);
+    sent_input_->append((*input_)[timeindex_to_send]);
+    sent_frames_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void CanBusReplay::loop() {
+  const double start_s = real_time_tools::Timer::get_current_time_sec();
+  const nanosecs_abs_t first_timestamp =
+      frames_.empty() ? 0 : frames_.front().timestamp;
+
+  for (size_t i = 0; i < frames_.size() && is_loop_active_; i++) {
+    CanBusFrame frame = frames_[i];
+    if (speed_ > 0.0 && frame.timestamp > first_timestamp) {
+      real_time_tools::Timer::sleep_until_sec(
+          start_s + 1e-9 * (frame.timestamp - first_timestamp) / speed_);
+    }
+    if (!is_received_[frame.id & CAN_SFF_MASK] ||
+        (is_filtering_ && (frame.id & (CAN_EFF_FLAG | CAN_RTR_FLAG)))) {
+      continue;
+    }
+    frame.timestamp = get_wall_time_ns();
+    output_->append(frame);
+    received_frames_.fetch_add(1, std::memory_order_relaxed);
+  }
+  is_done_ = true;
+}
+
+} // namespace monopod_drivers
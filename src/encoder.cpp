@@ -5,22 +5,61 @@ namespace monopod_drivers {
 Encoder::Encoder(Ptr<monopod_drivers::ControlBoardsInterface> board,
                  monopod_drivers::JointNamesIndex encoder_id)
     : board_(board), encoder_id_(encoder_id) {
+  switch (encoder_id_) {
+  case hip_joint:
+  case knee_joint:
+    board_index_ = ControlBoardsInterface::motor_board;
+    break;
+  case planarizer_pitch_joint:
+  case planarizer_yaw_joint:
+    board_index_ = ControlBoardsInterface::encoder_board1;
+    break;
+  case boom_connector_joint:
+    board_index_ = ControlBoardsInterface::encoder_board2;
+    break;
+  default:
+    throw std::invalid_argument(
+        "When activating board, encoder_id needs to match one of the joints "
+        "in the JointNamesIndex enum. The provided value was, " +
+        std::to_string(encoder_id_));
+  }
+
+  // Resolve the channels once, the getters are then simple lookups.
+  for (int i = 0; i < measurement_count; i++) {
+    const Measurements index = static_cast<Measurements>(i);
+    set_measurement_channel(index, find_measurement_index(encoder_id_, index));
+  }
   set_board_active();
 }
 
-Ptr<const ScalarTimeseries>
-Encoder::get_measurement(const Measurements &index) const {
-  switch (encoder_id_) {
+void Encoder::set_measurement_channel(const Measurements &index,
+                                      const int &measurement_index) {
+  measurement_indices_[index] = measurement_index;
+  measurement_channels_[index] =
+      measurement_index < 0 ? nullptr
+                            : board_->get_measurement(measurement_index).get();
+}
+
+int Encoder::get_measurement_index(const Measurements &index) const {
+  if (index < measurement_count && measurement_indices_[index] >= 0) {
+    return measurement_indices_[index];
+  }
+  throw std::invalid_argument("index needs to match one of the measurements");
+}
+
+int Encoder::find_measurement_index(const JointNamesIndex &encoder_id,
+                                    const Measurements &index) {
+  switch (encoder_id) {
   case hip_joint:
     switch (index) {
     case position:
-      return board_->get_measurement(ControlBoardsInterface::position_0);
+      return ControlBoardsInterface::position_0;
     case velocity:
-      return board_->get_measurement(ControlBoardsInterface::velocity_0);
+      return ControlBoardsInterface::velocity_0;
     case acceleration:
-      return board_->get_measurement(ControlBoardsInterface::acceleration_0);
+      return ControlBoardsInterface::acceleration_0;
     case encoder_index:
-      return board_->get_measurement(ControlBoardsInterface::encoder_index_0);
+      return ControlBoardsInterface::encoder_index_0;
     default:
       break;
     }
@@ -28,13 +67,13 @@ Encoder::get_measurement(const Measurements &index) const {
   case knee_joint:
     switch (index) {
     case position:
-      return board_->get_measurement(ControlBoardsInterface::position_1);
+      return ControlBoardsInterface::position_1;
     case velocity:
-      return board_->get_measurement(ControlBoardsInterface::velocity_1);
+      return ControlBoardsInterface::velocity_1;
     case acceleration:
-      return board_->get_measurement(ControlBoardsInterface::acceleration_1);
+      return ControlBoardsInterface::acceleration_1;
     case encoder_index:
-      return board_->get_measurement(ControlBoardsInterface::encoder_index_1);
+      return ControlBoardsInterface::encoder_index_1;
     default:
       break;
     }
@@ -42,13 +81,13 @@ Encoder::get_measurement(const Measurements &index) const {
   case planarizer_pitch_joint:
     switch (index) {
     case position:
-      return board_->get_measurement(ControlBoardsInterface::position_2);
+      return ControlBoardsInterface::position_2;
     case velocity:
-      return board_->get_measurement(ControlBoardsInterface::velocity_2);
+      return ControlBoardsInterface::velocity_2;
     case acceleration:
-      return board_->get_measurement(ControlBoardsInterface::acceleration_2);
+      return ControlBoardsInterface::acceleration_2;
     case encoder_index:
-      return board_->get_measurement(ControlBoardsInterface::encoder_index_2);
+      return ControlBoardsInterface::encoder_index_2;
     default:
       break;
     }
@@ -56,13 +95,13 @@ Encoder::get_measurement(const Measurements &index) const {
   case planarizer_yaw_joint:
     switch (index) {
     case position:
-      return board_->get_measurement(ControlBoardsInterface::position_3);
+      return ControlBoardsInterface::position_3;
     case velocity:
-      return board_->get_measurement(ControlBoardsInterface::velocity_3);
+      return ControlBoardsInterface::velocity_3;
     case acceleration:
-      return board_->get_measurement(ControlBoardsInterface::acceleration_3);
+      return ControlBoardsInterface::acceleration_3;
     case encoder_index:
-      return board_->get_measurement(ControlBoardsInterface::encoder_index_3);
+      return ControlBoardsInterface::encoder_index_3;
     default:
       break;
     }
@@ -70,55 +109,32 @@ Encoder::get_measurement(const Measurements &index) const {
   case boom_connector_joint:
     switch (index) {
     case position:
-      return board_->get_measurement(ControlBoardsInterface::position_4);
+      return ControlBoardsInterface::position_4;
     case velocity:
-      return board_->get_measurement(ControlBoardsInterface::velocity_4);
+      return ControlBoardsInterface::velocity_4;
     case acceleration:
-      return board_->get_measurement(ControlBoardsInterface::acceleration_4);
+      return ControlBoardsInterface::acceleration_4;
     case encoder_index:
-      return board_->get_measurement(ControlBoardsInterface::encoder_index_4);
+      return ControlBoardsInterface::encoder_index_4;
     default:
       break;
     }
     break;
   }
+  return -1;
+}
 
-  throw std::invalid_argument("index needs to match one of the measurements");
+Ptr<const ScalarTimeseries>
+Encoder::get_measurement(const Measurements &index) const {
+  return board_->get_measurement(get_measurement_index(index));
 }
 
 Ptr<const Encoder::StatusTimeseries> Encoder::get_status() const {
-  switch (encoder_id_) {
-  case hip_joint:
-  case knee_joint:
-    return board_->get_status(ControlBoardsInterface::motor_board);
-  case planarizer_pitch_joint:
-  case planarizer_yaw_joint:
-    return board_->get_status(ControlBoardsInterface::encoder_board1);
-  case boom_connector_joint:
-    return board_->get_status(ControlBoardsInterface::encoder_board2);
-  }
-  throw std::invalid_argument(
-      "index needs to match one of the boards in control board interface");
+  return board_->get_status(board_index_);
 }
 
 void Encoder::set_board_active() const {
-  switch (encoder_id_) {
-  case hip_joint:
-  case knee_joint:
-    board_->set_active_board(ControlBoardsInterface::motor_board);
-    return;
-  case planarizer_pitch_joint:
-  case planarizer_yaw_joint:
-    board_->set_active_board(ControlBoardsInterface::encoder_board1);
-    return;
-  case boom_connector_joint:
-    board_->set_active_board(ControlBoardsInterface::encoder_board2);
-    return;
-  }
-  throw std::invalid_argument(
-      "When activating board, encoder_id needs to match one of the joints in "
-      "the JointNamesIndex enum. The provided value was, " +
-      std::to_string(encoder_id_));
+  board_->set_active_board(board_index_);
 }
 
 void Encoder::print() const {
@@ -131,15 +147,16 @@ void Encoder::print() const {
     encoder_board_status = get_status()->newest_element();
   }
 
-  if (get_measurement(position)->length() != 0) {
+  if (get_measurement(position) && get_measurement(position)->length() != 0) {
     encoder_position = get_measurement(position)->newest_element();
   }
 
-  if (get_measurement(velocity)->length() != 0) {
+  if (get_measurement(velocity) && get_measurement(velocity)->length() != 0) {
     encoder_velocity = get_measurement(velocity)->newest_element();
   }
 
-  if (get_measurement(acceleration)->length() != 0) {
+  if (get_measurement(acceleration) &&
+      get_measurement(acceleration)->length() != 0) {
     encoder_acceleration = get_measurement(acceleration)->newest_element();
   }
 
@@ -12,6 +12,13 @@ EncoderJointModule::EncoderJointModule(
     const bool &reverse_polarity)
     : joint_id_(joint_id), encoder_(encoder), gear_ratio_(gear_ratio),
       polarity_(reverse_polarity ? -1.0 : 1.0) {
+  // Resolve the channels once, reading a measurement is then a lookup.
+  for (int i = 0; i < measurement_count; i++) {
+    const Measurements index = static_cast<Measurements>(i);
+    channels_[index] = encoder_->get_measurement_channel(index);
+    measurement_indices_[index] =
+        channels_[index] ? encoder_->get_measurement_index(index) : -1;
+  }
   set_zero_angle(zero_angle);
 }
 
@@ -42,11 +49,30 @@ double EncoderJointModule::get_measured_index_angle() const {
 
 double EncoderJointModule::get_zero_angle() const { return zero_angle_; }
 
+void EncoderJointModule::read_joint_state(const BoardsSnapshot &snapshot,
+                                          double &position, double &velocity,
+                                          double &acceleration) const {
+  // The measurements which are not provided or not streamed read as NaN.
+  double values[3];
+  const Measurements indices[3] = {Measurements::position,
+                                   Measurements::velocity,
+                                   Measurements::acceleration};
+  for (size_t i = 0; i < 3; i++) {
+    const int measurement_index = measurement_indices_[indices[i]];
+    values[i] = measurement_index < 0
+                    ? std::numeric_limits<double>::quiet_NaN()
+                    : snapshot.measurements[measurement_index];
+  }
+  position = polarity_ * values[0] / gear_ratio_ - zero_angle_;
+  velocity = polarity_ * values[1] / gear_ratio_;
+  acceleration = polarity_ * values[2] / gear_ratio_;
+}
+
 double EncoderJointModule::get_joint_measurement(
     const Measurements &measurement_id) const {
-  auto measurement_history = encoder_->get_measurement(measurement_id);
+  const ScalarTimeseries *measurement_history = channels_[measurement_id];
 
-  if (measurement_history->length() == 0) {
+  if (measurement_history == nullptr || measurement_history->length() == 0) {
     return std::numeric_limits<double>::quiet_NaN();
   }
 
@@ -55,9 +81,9 @@ double EncoderJointModule::get_joint_measurement(
 
 long int EncoderJointModule::get_joint_measurement_index(
     const Measurements &measurement_id) const {
-  auto measurement_history = encoder_->get_measurement(measurement_id);
+  const ScalarTimeseries *measurement_history = channels_[measurement_id];
 
-  if (measurement_history->length() == 0) {
+  if (measurement_history == nullptr || measurement_history->length() == 0) {
     return -1;
   }
 
@@ -66,50 +92,44 @@ long int EncoderJointModule::get_joint_measurement_index(
 
 void EncoderJointModule::set_limit(const Measurements &index,
                                    const JointLimit &limit) {
-  limit_door_.lock();
+  if (index >= limit_count) {
+    throw std::invalid_argument("only the position, velocity and acceleration "
+                                "can be limited.");
+  }
+  std::lock_guard<std::mutex> lock(limit_door_);
   limits_[index] = limit;
-  limit_door_.unlock();
+  published_limits_.store(limits_);
 }
 
 JointLimit EncoderJointModule::get_limit(const Measurements &index) const {
-  limit_door_.lock();
-  return limits_.at(index);
-  limit_door_.unlock();
+  if (index >= limit_count) {
+    throw std::invalid_argument("only the position, velocity and acceleration "
+                                "can be limited.");
+  }
+  JointLimits limits;
+  published_limits_.load(limits);
+  return limits[index];
 }
 
 bool EncoderJointModule::check_limits() const {
-  limit_door_.lock();
-  bool valid = true;
-  for (const auto &limit_info : limits_) {
-    auto meassurement_id = limit_info.first;
-    auto joint_limit = limit_info.second;
-
-    // Todo: maybe clean up how this is formatted. dont like this case
-    // statement.
-    double meassurement;
-    switch (meassurement_id) {
-    case position:
-      meassurement = get_measured_angle();
-      break;
-    case velocity:
-      meassurement = get_measured_velocity();
-      break;
-    case acceleration:
-      meassurement = get_measured_acceleration();
-      break;
-    default:
-      meassurement = 0;
-      break;
-    }
-
-    if (!(std::isnan(meassurement) &&
-          meassurement_id == Measurements::acceleration)) {
-      valid = valid &&
-              in_range<double>(meassurement, joint_limit.min, joint_limit.max);
-    }
-  }
-  limit_door_.unlock();
-  return valid;
+  JointLimits limits;
+  published_limits_.load(limits);
+
+  const double measured_angle = get_measured_angle();
+  const double measured_velocity = get_measured_velocity();
+  const double measured_acceleration = get_measured_acceleration();
+
+  // The measurements which are not streamed or not provided by the boards
+  // always read as NaN, they are not checked.
+  return (!channels_[position] ||
+          in_range<double>(measured_angle, limits[position].min,
+                           limits[position].max)) &&
+         (!channels_[velocity] ||
+          in_range<double>(measured_velocity, limits[velocity].min,
+                           limits[velocity].max)) &&
+         (!channels_[acceleration] ||
+          in_range<double>(measured_acceleration, limits[acceleration].min,
+                           limits[acceleration].max));
 }
 
 void EncoderJointModule::print() const { encoder_->print(); }
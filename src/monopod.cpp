@@ -1,4 +1,5 @@
 #include "monopod_sdk/monopod.hpp"
+#include "monopod_sdk/monopod_drivers/devices/can_bus_replay.hpp"
 #include <cassert>
 #include <stdexcept>
 
@@ -11,7 +12,7 @@ namespace monopod_drivers {
 // Public methods
 //===================================================================
 
-Monopod::Monopod() {
+Monopod::Monopod() : safety_monitor_("safety_loop", 0.001) {
   safety_loop_running = false;
   pause_safety_loop = false;
   current_state_ = MonopodState::NOT_INITIALIZED;
@@ -24,17 +25,80 @@ Monopod::~Monopod() {
   reset(false);
 }
 
-bool Monopod::initialize(Mode monopod_mode, bool dummy_mode) {
+bool Monopod::initialize(Mode monopod_mode, bool dummy_mode,
+                         const MonopodConfig &config) {
+  config.history.validate();
+  // Lock and prefault the memory before the threads are spawned, such that
+  // their stacks are locked as well.
+  config.realtime.memory.apply();
+  config.realtime.safety.apply(rt_thread_safety_);
+  realtime_ = config.realtime;
   dummy_mode_ = dummy_mode;
-  if (!dummy_mode) {
-    can_bus_ = std::make_shared<monopod_drivers::CanBus>("can0");
-    board_ = std::make_shared<monopod_drivers::CanBusControlBoards>(can_bus_);
+  safety_period_s_ = config.safety_period_s;
+  if (!dummy_mode && !config.replay_log.empty()) {
+    // Decode a recorded log, all the boards are on the replayed bus.
+    auto replay = std::make_shared<monopod_drivers::CanBusReplay>(
+        config.replay_log, config.replay_speed);
+    can_buses_.push_back(replay);
+    std::array<int, ControlBoardsInterface::board_count> board_buses;
+    board_buses.fill(0);
+    const Vector<monopod_drivers::ThreadPolicy> decode_threads = {
+        config.realtime.decode};
+    board_ = std::make_shared<monopod_drivers::CanBusControlBoards>(
+        can_buses_, board_buses, decode_threads, config.history,
+        config.streaming);
+    board_->reset();
+    // The boards listen to the bus now, the status frames of the log make
+    // them ready.
+    replay->start();
+
+  } else if (!dummy_mode) {
+    // Create one can bus per interface and map the boards onto them.
+    Vector<std::string> interfaces;
+    Vector<Ptr<monopod_drivers::CanBusInterface>> can_buses;
+    Vector<monopod_drivers::ThreadPolicy> decode_threads;
+    std::array<int, ControlBoardsInterface::board_count> board_buses;
+    for (size_t board = 0; board < config.can_interfaces.size(); board++) {
+      const std::string &interface_name = config.can_interfaces[board];
+      auto found =
+          std::find(interfaces.begin(), interfaces.end(), interface_name);
+      if (found == interfaces.end()) {
+        monopod_drivers::ThreadPolicy receive_thread =
+            config.realtime.can_receive;
+        monopod_drivers::ThreadPolicy decode_thread = config.realtime.decode;
+        auto cpu = config.receive_cpus.find(interface_name);
+        if (cpu != config.receive_cpus.end()) {
+          receive_thread.cpu = cpu->second;
+          decode_thread.cpu = cpu->second;
+        }
+
+        can_buses_.push_back(std::make_shared<monopod_drivers::CanBus>(
+            interface_name, config.history.frame_length, receive_thread,
+            config.can_transmit));
+        can_buses.push_back(can_buses_.back());
+        decode_threads.push_back(decode_thread);
+        interfaces.push_back(interface_name);
+        found = interfaces.end() - 1;
+      }
+      board_buses[board] = found - interfaces.begin();
+    }
+
+    board_ = std::make_shared<monopod_drivers::CanBusControlBoards>(
+        can_buses, board_buses, decode_threads, config.history,
+        config.streaming);
     board_->reset();
 
   } else {
-    board_ = std::make_shared<monopod_drivers::DummyControlBoards>();
+    board_ = std::make_shared<monopod_drivers::SimulatedControlBoards>(
+        config.simulation, config.history, config.realtime.simulation);
   }
 
+  recorder_ = std::make_shared<monopod_drivers::TelemetryRecorder>(
+      1 << 16, config.realtime.telemetry);
+  board_->set_recorder(recorder_);
+
+  encoders_.fill(nullptr);
+  motors_.fill(nullptr);
   encoder_joint_indexing = {};
   motor_joint_indexing = {};
 
@@ -73,7 +137,9 @@ bool Monopod::initialize(Mode monopod_mode, bool dummy_mode) {
     motors_[hip_joint] = motor_hip;
     motors_[knee_joint] = motor_knee;
 
-    leg_ = std::make_unique<monopod_drivers::Leg>(motor_hip, motor_knee);
+    leg_ = std::make_unique<monopod_drivers::Leg>(
+        motor_hip, motor_knee, board_, config.realtime.leg_hold,
+        config.realtime.leg_trajectory);
 
     encoder_joint_indexing.push_back(hip_joint);
     encoder_joint_indexing.push_back(knee_joint);
@@ -99,7 +165,45 @@ bool Monopod::initialize(Mode monopod_mode, bool dummy_mode) {
     encoder_joint_indexing.push_back(boom_connector_joint);
     break;
   }
-  board_->wait_until_ready();
+
+  encoder_joints_ = 0;
+  for (const auto &joint_index : encoder_joint_indexing) {
+    encoder_joints_ |= 1u << joint_index;
+  }
+  motor_joints_ = 0;
+  for (const auto &joint_index : motor_joint_indexing) {
+    motor_joints_ |= 1u << joint_index;
+  }
+  board_->wait_until_ready(config.readiness);
+
+  const int trigger_joint = motor_joint_indexing.empty()
+                                ? encoder_joint_indexing.front()
+                                : hip_joint;
+  state_trigger_ = board_->get_measurement(
+      encoders_[trigger_joint]->get_measurement_index(position));
+  if (!state_trigger_) {
+    throw std::invalid_argument("the positions of the joints must be "
+                                "streamed, see MonopodConfig::streaming.");
+  }
+  state_timeindex_ = state_trigger_->length() == 0
+                         ? -1
+                         : state_trigger_->newest_timeindex(false);
+
+  {
+    // Only the measurements streamed by the boards are checked, the others
+    // always read as NaN.
+    std::lock_guard<std::mutex> lock(safety_limits_door_);
+    for (size_t i = 0; i < SafetyLimits::limit_count; i++) {
+      const Measurements index = static_cast<Measurements>(i);
+      safety_limits_.checked_joints[i] = 0;
+      for (const auto &joint_index : encoder_joint_indexing) {
+        if (encoders_[joint_index]->get_measurement_index(index) >= 0) {
+          safety_limits_.checked_joints[i] |= 1u << joint_index;
+        }
+      }
+    }
+    published_safety_limits_.store(safety_limits_);
+  }
 
   current_state_ = motor_joint_indexing.empty() ? MonopodState::READ_ONLY
                                                 : MonopodState::RUNNING;
@@ -126,8 +230,8 @@ void Monopod::print(const Vector<int> &joint_indexes) const {
       joint_indexes.empty() ? encoder_joint_indexing : joint_indexes;
 
   for (auto &joint_index : jointSerialization) {
-    if (Contains(encoder_joint_indexing, joint_index)) {
-      encoders_.at(joint_index)->print();
+    if (is_encoder_joint(joint_index)) {
+      encoders_[joint_index]->print();
     }
   }
 }
@@ -156,6 +260,12 @@ void Monopod::goto_position(const double &hip_home_position,
               << std::endl;
     return;
   }
+  if (leg_->is_homing()) {
+    std::cerr << "Monopod::goto_position(): Tried to goto_position while "
+                 "calibrating, see get_calibration_progress."
+              << std::endl;
+    return;
+  }
 
   // Disable limits to avoid triggering the safemode.
   pause_safety_loop = true;
@@ -167,20 +277,53 @@ void Monopod::goto_position(const double &hip_home_position,
   // start limit loop again if it was active before
   pause_safety_loop = false;
 }
-void Monopod::hold_position() {
+bool Monopod::queue_trajectory(
+    const Vector<std::array<double, NUMBER_LEG_JOINTS>> &waypoints,
+    const double &average_speed_rad_per_sec) {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  if (current_state_ != MonopodState::RUNNING) {
+    std::cerr << "Monopod::queue_trajectory(): Tried to queue a trajectory "
+                 "when not in [MonopodState::RUNNING]. This means the "
+                 "robot is HOLDING or in READ_ONLY mode with no active motors."
+              << std::endl;
+    return false;
+  }
+  return leg_->queue_trajectory(waypoints, average_speed_rad_per_sec);
+}
+
+bool Monopod::is_trajectory_done() const {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  return motor_joint_indexing.empty() ? true : leg_->is_trajectory_done();
+}
+
+void Monopod::stop_trajectory() {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  if (!motor_joint_indexing.empty()) {
+    leg_->stop_trajectory();
+  }
+}
+
+void Monopod::hold_position(const double &period_s) {
 
   assertm(initialized(), "Requires monopod_sdk is initialized.");
   assertm(current_state_ == MonopodState::RUNNING,
           "Monopod must be in the state [MonopodState::RUNNING] before holding "
           "current position.");
+  if (leg_->is_homing()) {
+    std::cerr << "Monopod::hold_position(): Tried to hold the position while "
+                 "calibrating, see get_calibration_progress."
+              << std::endl;
+    return;
+  }
 
   // Disable limits to avoid triggering the safemode.
   pause_safety_loop = true;
   // Make sure we are in a reset state before going to zero.
   board_->reset();
-  leg_->start_holding_loop();
-  // Reset here pauses the motors again.
-  board_->reset();
+  leg_->start_holding_loop(period_s);
+  if (leg_->is_hold_current_pos()) {
+    current_state_ = MonopodState::HOLDING;
+  }
   // start limit loop again if it was active before
   pause_safety_loop = false;
 }
@@ -199,6 +342,8 @@ void Monopod::stop_hold_position() {
   }
 
   leg_->stop_hold_current_pos();
+  // Reset here pauses the motors again.
+  board_->reset();
   current_state_ = MonopodState::RUNNING;
 }
 
@@ -214,28 +359,27 @@ void Monopod::start_safety_loop() {
   safety_loop_running = true;
   rt_printf("Starting realtime safety loop to ensure physical limits of robot "
             "stay within a safety margin. \n");
+  safety_monitor_.set_period(safety_period_s_ > 0.0 ? safety_period_s_
+                                                    : 0.001);
+  safety_monitor_.restart();
   rt_thread_safety_.create_realtime_thread(&Monopod::safety_loop, this);
 }
 
 void Monopod::calibrate(const double &hip_home_offset_rad,
-                        const double &knee_home_offset_rad) {
+                        const double &knee_home_offset_rad,
+                        const HomingConfig &config) {
 
-  // todo: Make calibration more robust??
   // todo: Update zero for none motor joints. Right now we can just use reset
   // button to get new zero when in physical spot.
 
-  // Check to make sure that the sdk is initialized.
-  assertm(initialized(), "Requires monopod_sdk is initialized.");
-  // todo: make sure this is worth terminating for.
-  assertm(current_state_ == MonopodState::RUNNING,
-          "Not in state [MonopodState::RUNNING]. This could mean the robot is "
-          "HOLDING or in READ_ONLY mode with no active motors.");
-
-  // Disable limits to avoid triggering the safemode.
-  pause_safety_loop = true;
-  // Make sure we are in a reset state before going to zero.
-  board_->reset();
-  bool status = leg_->calibrate(hip_home_offset_rad, knee_home_offset_rad);
+  bool status =
+      start_calibration(hip_home_offset_rad, knee_home_offset_rad, config);
+  HomingProgress progress = get_calibration_progress();
+  while (status && progress.is_running()) {
+    real_time_tools::Timer::sleep_ms(10.0);
+    progress = get_calibration_progress();
+  }
+  status = status && progress.phase == HomingPhase::SUCCEEDED;
   // If status fail cout a error or warning.
   if (!status) {
     std::cerr << "Monopod::calibrate(): [Warn] Failed to reach desired final "
@@ -244,13 +388,35 @@ void Monopod::calibrate(const double &hip_home_offset_rad,
   }
   // Reset here pauses the motors again.
   board_->reset();
-  // start limit loop again if it was active before
-  pause_safety_loop = false;
+}
+
+bool Monopod::start_calibration(const double &hip_home_offset_rad,
+                                const double &knee_home_offset_rad,
+                                const HomingConfig &config) {
+  // Check to make sure that the sdk is initialized.
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  // todo: make sure this is worth terminating for.
+  assertm(current_state_ == MonopodState::RUNNING,
+          "Not in state [MonopodState::RUNNING]. This could mean the robot is "
+          "HOLDING or in READ_ONLY mode with no active motors.");
+  if (!leg_ || leg_->is_homing()) {
+    return false;
+  }
+
+  // Make sure we are in a reset state before searching the indexes.
+  board_->reset();
+  return leg_->start_homing(hip_home_offset_rad, knee_home_offset_rad,
+                            config);
+}
+
+HomingProgress Monopod::get_calibration_progress() const {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  return leg_ ? leg_->get_homing_progress() : HomingProgress();
 }
 
 bool Monopod::is_joint_controllable(const int joint_index) {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  return Contains(motor_joint_indexing, joint_index);
+  return is_motor_joint(joint_index);
 }
 
 // ========================================
@@ -264,8 +430,7 @@ std::unordered_map<std::string, int> Monopod::get_joint_names() const {
 
   std::unordered_map<std::string, int> joint_names_;
   for (auto const &pair : joint_names) {
-    if (Contains(encoder_joint_indexing, pair.second) ||
-        Contains(motor_joint_indexing, pair.second)) {
+    if (is_encoder_joint(pair.second) || is_motor_joint(pair.second)) {
       joint_names_[pair.first] = pair.second;
     }
   }
@@ -278,7 +443,7 @@ std::optional<PID> Monopod::get_pid(const int &joint_index) const {
   assertm(false, "NotImplementedError.");
 
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(motor_joint_indexing, joint_index)) {
+  if (is_motor_joint(joint_index)) {
     // todo Implement PID read/write
   }
 
@@ -288,8 +453,8 @@ std::optional<PID> Monopod::get_pid(const int &joint_index) const {
 std::optional<JointLimit>
 Monopod::get_joint_position_limit(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    return encoders_.at(joint_index)->get_limit(position);
+  if (is_encoder_joint(joint_index)) {
+    return encoders_[joint_index]->get_limit(position);
   }
   return std::nullopt;
 }
@@ -297,8 +462,8 @@ Monopod::get_joint_position_limit(const int &joint_index) const {
 std::optional<JointLimit>
 Monopod::get_joint_velocity_limit(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    return encoders_.at(joint_index)->get_limit(velocity);
+  if (is_encoder_joint(joint_index)) {
+    return encoders_[joint_index]->get_limit(velocity);
   }
   return std::nullopt;
 }
@@ -306,16 +471,16 @@ Monopod::get_joint_velocity_limit(const int &joint_index) const {
 std::optional<JointLimit>
 Monopod::get_joint_acceleration_limit(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    return encoders_.at(joint_index)->get_limit(acceleration);
+  if (is_encoder_joint(joint_index)) {
+    return encoders_[joint_index]->get_limit(acceleration);
   }
   return std::nullopt;
 }
 
 std::optional<double> Monopod::get_torque_target(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(motor_joint_indexing, joint_index)) {
-    return motors_.at(joint_index)->get_measured_torque();
+  if (is_motor_joint(joint_index)) {
+    return motors_[joint_index]->get_measured_torque();
   }
   return std::nullopt;
 }
@@ -331,9 +496,9 @@ Monopod::get_torque_targets(const Vector<int> &joint_indexes) const {
   Vector<double> data;
   data.reserve(jointSerialization.size());
   for (auto &joint_index : jointSerialization) {
-    if (Contains(motor_joint_indexing, joint_index)) {
+    if (is_motor_joint(joint_index)) {
       // note: maybe we cna call the single version here.
-      data.push_back(motors_.at(joint_index)->get_measured_torque());
+      data.push_back(motors_[joint_index]->get_measured_torque());
       continue;
     } else {
       return std::nullopt;
@@ -342,26 +507,39 @@ Monopod::get_torque_targets(const Vector<int> &joint_indexes) const {
   return data;
 }
 
+bool Monopod::get_torque_targets(
+    Eigen::Ref<Eigen::VectorXd> torque_targets) const {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  if (torque_targets.size() != NUMBER_LEG_JOINTS) {
+    return false;
+  }
+  StateSnapshot state;
+  read_state(state);
+  torque_targets = Eigen::Map<const Eigen::VectorXd>(state.torque.data(),
+                                                     NUMBER_LEG_JOINTS);
+  return true;
+}
+
 std::optional<double> Monopod::get_position(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    return encoders_.at(joint_index)->get_measured_angle();
+  if (is_encoder_joint(joint_index)) {
+    return encoders_[joint_index]->get_measured_angle();
   }
   return std::nullopt;
 }
 
 std::optional<double> Monopod::get_velocity(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    return encoders_.at(joint_index)->get_measured_velocity();
+  if (is_encoder_joint(joint_index)) {
+    return encoders_[joint_index]->get_measured_velocity();
   }
   return std::nullopt;
 }
 
 std::optional<double> Monopod::get_acceleration(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    return encoders_.at(joint_index)->get_measured_acceleration();
+  if (is_encoder_joint(joint_index)) {
+    return encoders_[joint_index]->get_measured_acceleration();
   }
   return std::nullopt;
 }
@@ -369,8 +547,10 @@ std::optional<double> Monopod::get_acceleration(const int &joint_index) const {
 std::optional<Vector<double>>
 Monopod::get_positions(const Vector<int> &joint_indexes) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  auto lambda = [this](int joint_index) -> double {
-    return encoders_.at(joint_index)->get_measured_angle();
+  StateSnapshot state;
+  read_state(state);
+  auto lambda = [&state](int joint_index) -> double {
+    return state.position[joint_index];
   };
 
   return getJointDataSerialized(this, joint_indexes, lambda);
@@ -379,8 +559,10 @@ Monopod::get_positions(const Vector<int> &joint_indexes) const {
 std::optional<Vector<double>>
 Monopod::get_velocities(const Vector<int> &joint_indexes) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  auto lambda = [this](int joint_index) -> double {
-    return encoders_.at(joint_index)->get_measured_velocity();
+  StateSnapshot state;
+  read_state(state);
+  auto lambda = [&state](int joint_index) -> double {
+    return state.velocity[joint_index];
   };
 
   return getJointDataSerialized(this, joint_indexes, lambda);
@@ -389,18 +571,112 @@ Monopod::get_velocities(const Vector<int> &joint_indexes) const {
 std::optional<Vector<double>>
 Monopod::get_accelerations(const Vector<int> &joint_indexes) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  auto lambda = [this](int joint_index) -> double {
-    return encoders_.at(joint_index)->get_measured_acceleration();
+  StateSnapshot state;
+  read_state(state);
+  auto lambda = [&state](int joint_index) -> double {
+    return state.acceleration[joint_index];
   };
 
   return getJointDataSerialized(this, joint_indexes, lambda);
 }
 
+bool Monopod::get_positions(Eigen::Ref<Eigen::VectorXd> positions) const {
+  if (positions.size() != NUMBER_JOINTS) {
+    return false;
+  }
+  StateSnapshot state;
+  read_state(state);
+  positions =
+      Eigen::Map<const Eigen::VectorXd>(state.position.data(), NUMBER_JOINTS);
+  return true;
+}
+
+bool Monopod::get_velocities(Eigen::Ref<Eigen::VectorXd> velocities) const {
+  if (velocities.size() != NUMBER_JOINTS) {
+    return false;
+  }
+  StateSnapshot state;
+  read_state(state);
+  velocities =
+      Eigen::Map<const Eigen::VectorXd>(state.velocity.data(), NUMBER_JOINTS);
+  return true;
+}
+
+bool Monopod::get_accelerations(
+    Eigen::Ref<Eigen::VectorXd> accelerations) const {
+  if (accelerations.size() != NUMBER_JOINTS) {
+    return false;
+  }
+  StateSnapshot state;
+  read_state(state);
+  accelerations = Eigen::Map<const Eigen::VectorXd>(state.acceleration.data(),
+                                                    NUMBER_JOINTS);
+  return true;
+}
+
+void Monopod::read_state(StateSnapshot &state) const {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  BoardsSnapshot snapshot;
+  board_->get_snapshot(snapshot);
+  read_latency_.record_since(snapshot.publish_time_ns);
+
+  state.position.fill(std::numeric_limits<double>::quiet_NaN());
+  state.velocity.fill(std::numeric_limits<double>::quiet_NaN());
+  state.acceleration.fill(std::numeric_limits<double>::quiet_NaN());
+  state.torque.fill(std::numeric_limits<double>::quiet_NaN());
+  state.valid_joints = encoder_joints_;
+  state.frame_count = snapshot.frame_count;
+
+  for (const auto &joint_index : encoder_joint_indexing) {
+    encoders_[joint_index]->read_joint_state(
+        snapshot, state.position[joint_index], state.velocity[joint_index],
+        state.acceleration[joint_index]);
+  }
+  for (const auto &joint_index : motor_joint_indexing) {
+    state.torque[joint_index] =
+        motors_[joint_index]->get_measured_torque(snapshot);
+  }
+}
+
+bool Monopod::wait_for_new_state(const double &timeout_s) {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  if (!state_trigger_->wait_for_timeindex(state_timeindex_ + 1, timeout_s)) {
+    return false;
+  }
+  state_timeindex_ = state_trigger_->newest_timeindex(false);
+  return true;
+}
+
+bool Monopod::start_recording(const std::string &file_name) {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  return recorder_->start(file_name);
+}
+
+uint64_t Monopod::stop_recording() {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  recorder_->stop();
+  return recorder_->get_dropped_records();
+}
+
+MonopodStats Monopod::get_stats() const {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  MonopodStats stats;
+  stats.boards = board_->get_stats();
+  stats.read = read_latency_.get_summary();
+  stats.threads.push_back(safety_monitor_.get_stats());
+  if (leg_) {
+    Vector<ThreadStats> leg_threads = leg_->get_thread_stats();
+    stats.threads.insert(stats.threads.end(), leg_threads.begin(),
+                         leg_threads.end());
+  }
+  return stats;
+}
+
 std::optional<double>
 Monopod::get_max_torque_target(const int &joint_index) const {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(motor_joint_indexing, joint_index)) {
-    return motors_.at(joint_index)->get_max_torque();
+  if (is_motor_joint(joint_index)) {
+    return motors_[joint_index]->get_max_torque();
   }
   // Todo: make sure there isnt any issue with returning null optional for max
   // torque on a read only joint...
@@ -416,7 +692,7 @@ bool Monopod::set_pid(const int &p, const int &i, const int &d,
   assertm(false, "NotImplementedError");
 
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(motor_joint_indexing, joint_index)) {
+  if (is_motor_joint(joint_index)) {
     // todo Implement PID read/write
     PID pid(p, i, d);
     // motor_->set_pid(pid);
@@ -429,9 +705,8 @@ bool Monopod::set_pid(const int &p, const int &i, const int &d,
 bool Monopod::set_joint_position_limit(const double &max, const double &min,
                                        const int &joint_index) {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    JointLimit limit(min, max);
-    encoders_.at(joint_index)->set_limit(position, limit);
+  if (is_encoder_joint(joint_index)) {
+    set_joint_limit(position, joint_index, JointLimit(min, max));
     return true;
   }
   return false;
@@ -440,9 +715,8 @@ bool Monopod::set_joint_position_limit(const double &max, const double &min,
 bool Monopod::set_joint_velocity_limit(const double &max, const double &min,
                                        const int &joint_index) {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    JointLimit limit(min, max);
-    encoders_.at(joint_index)->set_limit(velocity, limit);
+  if (is_encoder_joint(joint_index)) {
+    set_joint_limit(velocity, joint_index, JointLimit(min, max));
     return true;
   }
   return false;
@@ -451,9 +725,8 @@ bool Monopod::set_joint_velocity_limit(const double &max, const double &min,
 bool Monopod::set_joint_acceleration_limit(const double &max, const double &min,
                                            const int &joint_index) {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(encoder_joint_indexing, joint_index)) {
-    JointLimit limit(min, max);
-    encoders_.at(joint_index)->set_limit(acceleration, limit);
+  if (is_encoder_joint(joint_index)) {
+    set_joint_limit(acceleration, joint_index, JointLimit(min, max));
     return true;
   }
   return false;
@@ -462,10 +735,10 @@ bool Monopod::set_joint_acceleration_limit(const double &max, const double &min,
 bool Monopod::set_max_torque_target(const double &max_torque_target,
                                     const int &joint_index) {
   assertm(initialized(), "Requires monopod_sdk is initialized.");
-  if (Contains(motor_joint_indexing, joint_index)) {
-    motors_.at(joint_index)->set_max_torque(max_torque_target);
+  if (is_motor_joint(joint_index)) {
+    motors_[joint_index]->set_max_torque(max_torque_target);
     return true;
-  } else if (Contains(encoder_joint_indexing, joint_index)) {
+  } else if (is_encoder_joint(joint_index)) {
     std::cerr << "Monopod::set_max_torque_target(): [Warn] Attempted to set "
                  "max torque on an encoder joint."
               << std::endl;
@@ -481,10 +754,10 @@ bool Monopod::set_torque_target(const double &torque_target,
           "Can not set torque target when not in state "
           "[MonopodState::RUNNING]. This could mean the robot is HOLDING or in "
           "READ_ONLY mode with no active motors.");
-  if (Contains(motor_joint_indexing, joint_index)) {
+  if (is_motor_joint(joint_index)) {
     /* automatically clip torque to max in joint module */
-    motors_.at(joint_index)->set_torque(torque_target);
-    motors_.at(joint_index)->send_torque();
+    motors_[joint_index]->set_torque(torque_target);
+    motors_[joint_index]->send_torque();
 
     return true;
   }
@@ -503,46 +776,124 @@ bool Monopod::set_torque_targets(const Vector<double> &torque_targets,
       joint_indexes.empty() ? motor_joint_indexing : joint_indexes;
 
   assertm(
-      torque_targets.size() != jointSerialization.size(),
+      torque_targets.size() == jointSerialization.size(),
       "Size of torque targets did not match the number of specified joints.");
 
-  bool ok = true;
+  return try_set_torque_targets(torque_targets, joint_indexes);
+}
 
-  for (size_t i = 0; i != torque_targets.size(); i++) {
-    if (Contains(motor_joint_indexing, jointSerialization[i])) {
+bool Monopod::try_set_torque_targets(const Vector<double> &torque_targets,
+                                     const Vector<int> &joint_indexes) {
+  if (current_state_ != MonopodState::RUNNING) {
+    return false;
+  }
 
-      motors_.at(jointSerialization[i])->set_torque(torque_targets[i]);
-      motors_.at(jointSerialization[i])->send_torque();
+  const Vector<int> &jointSerialization =
+      joint_indexes.empty() ? motor_joint_indexing : joint_indexes;
+  if (torque_targets.size() != jointSerialization.size()) {
+    return false;
+  }
 
-      ok = ok && true;
-    } else {
-      ok = ok && false;
+  // Validate every index before staging anything, a bad index must not leave
+  // the controls half updated.
+  for (const auto &joint_index : jointSerialization) {
+    if (!is_motor_joint(joint_index)) {
+      return false;
     }
   }
 
-  return ok;
+  // Stage the torque of every joint first...
+  for (size_t i = 0; i != torque_targets.size(); i++) {
+    motors_[jointSerialization[i]]->set_torque(torque_targets[i]);
+  }
+
+  // ...then commit once. All the motors live on the same board, so this puts a
+  // single IqRef frame holding the new hip/knee pair on the bus.
+  board_->send_if_input_changed();
+
+  return true;
+}
+
+bool Monopod::set_torque_targets(
+    const Eigen::Ref<const Eigen::VectorXd> &torque_targets) {
+  assertm(initialized(), "Requires monopod_sdk is initialized.");
+  assertm(current_state_ == MonopodState::RUNNING,
+          "Can not set torque target when not in state "
+          "[MonopodState::RUNNING]. This could mean the robot is HOLDING or in "
+          "READ_ONLY mode with no active motors.");
+  if (torque_targets.size() != NUMBER_LEG_JOINTS ||
+      !is_motor_joint(hip_joint) || !is_motor_joint(knee_joint)) {
+    return false;
+  }
+
+  motors_[hip_joint]->set_torque(torque_targets[hip_joint]);
+  motors_[knee_joint]->set_torque(torque_targets[knee_joint]);
+  board_->send_if_input_changed();
+
+  return true;
+}
+
+/**
+ * @brief Set the limit of a measurement of a joint in its module, and publish
+ * the limits of all the joints to the safety_loop.
+ */
+void Monopod::set_joint_limit(const Measurements &index,
+                              const int &joint_index,
+                              const JointLimit &limit) {
+  if (!is_encoder_joint(joint_index)) {
+    throw std::invalid_argument("the joint is not active.");
+  }
+  encoders_[joint_index]->set_limit(index, limit);
+
+  std::lock_guard<std::mutex> lock(safety_limits_door_);
+  safety_limits_.min[index][joint_index] = limit.min;
+  safety_limits_.max[index][joint_index] = limit.max;
+  published_safety_limits_.store(safety_limits_);
 }
 
 /**
- * @brief This is a 100Hz safety_loop that checks the limits of all joints. This
- * is done to make sure the monopod is not in a vulnerable state. Do not want to
- * break the robot.
+ * @brief This is the safety_loop that checks the limits of all joints. This is
+ * done to make sure the monopod is not in a vulnerable state. Do not want to
+ * break the robot. It runs every MonopodConfig::safety_period_s (1 ms by
+ * default), or on every new measurement if the period is 0.
  */
 void Monopod::safety_loop() {
+  const bool every_measurement = safety_period_s_ <= 0.0;
   real_time_tools::Spinner spinner;
-  // Check limits at 100hz
-  spinner.set_period(0.01);
+  spinner.set_period(every_measurement ? 0.001 : safety_period_s_);
 
+  // Newest measurement checked when running on every measurement.
+  Index checked_timeindex = state_trigger_->length() == 0
+                                ? -1
+                                : state_trigger_->newest_timeindex(false);
+
+  StateSnapshot state;
+  SafetyLimits limits;
   while (safety_loop_running) {
     while (pause_safety_loop) {
       spinner.spin();
     }
-    bool in_limits = true;
-    for (const auto &joint_index : encoder_joint_indexing) {
-      in_limits = in_limits && encoders_.at(joint_index)->check_limits();
+    if (every_measurement) {
+      // Wake up at least every 10 ms even if the boards are silent.
+      if (!state_trigger_->wait_for_timeindex(checked_timeindex + 1, 0.01)) {
+        continue;
+      }
+      checked_timeindex = state_trigger_->newest_timeindex(false);
+    }
+
+    safety_monitor_.tick();
+    read_state(state);
+    published_safety_limits_.load(limits);
+    if (leg_ && leg_->is_homing()) {
+      // The zero of the leg joints is being set, their positions are
+      // meaningless until the homing is over.
+      for (const int joint_index : {hip_joint, knee_joint}) {
+        limits.checked_joints[position] &= ~(1u << joint_index);
+      }
     }
-    if (!in_limits) {
-      // If the state is not in safemode already then enter safemode.
+    // If the state is not in safemode already then enter safemode. It is
+    // only entered once, it holds the zero controls until reset.
+    if (!limits.contains(state) && !board_->is_safemode()) {
       if (valid()) {
         rt_printf(
             "Monopod::safety_loop(): Robot entered safe mode because a "
@@ -551,8 +902,11 @@ void Monopod::safety_loop() {
       }
       board_->enter_safemode();
     }
-    // spin the RT safety_loop.
-    spinner.spin();
+
+    if (!every_measurement) {
+      // spin the RT safety_loop.
+      spinner.spin();
+    }
   }
 }
 
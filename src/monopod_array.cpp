@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "monopod_sdk/monopod_array.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief Current limit of the leg motors of a Monopod (A), see
+ * MotorJointModule.
+ */
+static constexpr double max_current = 0.9 * MAX_CURRENT;
+
+/**
+ * @brief Throw if a matrix is not sized for all the robots.
+ *
+ * @param rows of the matrix.
+ * @param robot_count
+ */
+static void check_rows(const Eigen::Index &rows, const size_t &robot_count) {
+  if (rows != static_cast<Eigen::Index>(robot_count)) {
+    throw std::invalid_argument("the matrix must have one row per robot.");
+  }
+}
+
+MonopodArray::MonopodArray(const size_t &robot_count,
+                           const SimulationParameters &parameters,
+                           const size_t &worker_count)
+    : robot_count_(robot_count), parameters_(parameters),
+      is_safemode_(RobotMask::Constant(robot_count, false)), step_count_(0),
+      workers_(worker_count) {
+  if (robot_count_ == 0) {
+    throw std::invalid_argument("a MonopodArray needs at least one robot.");
+  }
+  for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+    position_[i] = Eigen::VectorXd::Zero(robot_count_);
+    velocity_[i] = Eigen::VectorXd::Zero(robot_count_);
+    acceleration_[i] = Eigen::VectorXd::Zero(robot_count_);
+  }
+  for (auto &current : current_) {
+    current = Eigen::VectorXd::Zero(robot_count_);
+  }
+  position_limits_.fill({-std::numeric_limits<double>::infinity(),
+                         std::numeric_limits<double>::infinity()});
+}
+
+void MonopodArray::set_torque_targets(
+    const Eigen::Ref<const LegMatrix> &torques) {
+  check_rows(torques.rows(), robot_count_);
+  // Same conversion as the MotorJointModule of a Monopod, whose polarity is
+  // reversed.
+  const double scale =
+      -1.0 / (parameters_.gear_ratio * parameters_.motor_constant);
+  for (size_t joint = 0; joint < NUMBER_LEG_JOINTS; joint++) {
+    Eigen::VectorXd &current = current_[joint];
+    for (size_t robot = 0; robot < robot_count_; robot++) {
+      const double torque = torques(robot, joint);
+      const double target = torque == torque ? scale * torque : 0.0;
+      current[robot] = is_safemode_[robot]
+                           ? 0.0
+                           : std::min(max_current,
+                                      std::max(-max_current, target));
+    }
+  }
+}
+
+void MonopodArray::step(const size_t &step_count) {
+  workers_.run(robot_count_,
+               [this, &step_count](const size_t &begin, const size_t &end) {
+                 step_robots(begin, end, step_count);
+               });
+  step_count_ += step_count;
+}
+
+void MonopodArray::step_robots(const size_t &begin, const size_t &end,
+                               const size_t &step_count) {
+  SimulationStateView state;
+  for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+    state.position[i] = position_[i].data();
+    state.velocity[i] = velocity_[i].data();
+    state.acceleration[i] = acceleration_[i].data();
+  }
+  for (size_t i = 0; i < NUMBER_LEG_JOINTS; i++) {
+    state.current[i] = current_[i].data();
+  }
+
+  for (size_t i = 0; i < step_count; i++) {
+    SimulatedControlBoards::integrate_model(parameters_, state, begin, end);
+  }
+
+  for (int joint = 0; joint < NUMBER_JOINTS; joint++) {
+    const int model_index = SimulatedControlBoards::get_model_index(joint);
+    const auto &limit = position_limits_[joint];
+    for (size_t robot = begin; robot < end; robot++) {
+      const double position = -position_[model_index][robot];
+      if (!(position >= limit.first && position <= limit.second)) {
+        is_safemode_[robot] = true;
+      }
+    }
+  }
+  for (size_t robot = begin; robot < end; robot++) {
+    if (is_safemode_[robot]) {
+      for (auto &current : current_) {
+        current[robot] = 0.0;
+      }
+    }
+  }
+}
+
+void MonopodArray::get_state(Eigen::Ref<JointMatrix> positions,
+                             Eigen::Ref<JointMatrix> velocities,
+                             Eigen::Ref<JointMatrix> accelerations) const {
+  check_rows(positions.rows(), robot_count_);
+  check_rows(velocities.rows(), robot_count_);
+  check_rows(accelerations.rows(), robot_count_);
+  // The joints of a Monopod have a reversed polarity.
+  for (int joint = 0; joint < NUMBER_JOINTS; joint++) {
+    const int model_index = SimulatedControlBoards::get_model_index(joint);
+    positions.col(joint) = -position_[model_index];
+    velocities.col(joint) = -velocity_[model_index];
+    accelerations.col(joint) = -acceleration_[model_index];
+  }
+}
+
+void MonopodArray::reset() {
+  for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+    position_[i].setZero();
+    velocity_[i].setZero();
+    acceleration_[i].setZero();
+  }
+  for (auto &current : current_) {
+    current.setZero();
+  }
+  is_safemode_.setConstant(false);
+}
+
+void MonopodArray::reset(const size_t &robot, const JointVector &positions) {
+  if (robot >= robot_count_) {
+    throw std::invalid_argument("the robot does not exist.");
+  }
+  for (int joint = 0; joint < NUMBER_JOINTS; joint++) {
+    const int model_index = SimulatedControlBoards::get_model_index(joint);
+    position_[model_index][robot] = -positions[joint];
+    velocity_[model_index][robot] = 0.0;
+    acceleration_[model_index][robot] = 0.0;
+  }
+  for (auto &current : current_) {
+    current[robot] = 0.0;
+  }
+  is_safemode_[robot] = false;
+}
+
+void MonopodArray::set_position_limit(const int &joint_index,
+                                      const double &min, const double &max) {
+  if (joint_index < 0 || joint_index >= NUMBER_JOINTS) {
+    throw std::invalid_argument("unknown joint index.");
+  }
+  if (!(min <= max)) {
+    throw std::invalid_argument("the minimum must not exceed the maximum.");
+  }
+  position_limits_[joint_index] = {min, max};
+}
+
+} // namespace monopod_drivers
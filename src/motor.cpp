@@ -2,21 +2,18 @@
 
 namespace monopod_drivers {
 Motor::Motor(Ptr<ControlBoardsInterface> board, JointNamesIndex motor_id)
-    : Encoder(board, motor_id), board_(board), motor_id_(motor_id) {}
-
-Ptr<const ScalarTimeseries>
-Motor::get_measurement(const Measurements &index) const {
-  if (index == monopod_drivers::current) {
-    switch (motor_id_) {
-    case hip_joint:
-      return board_->get_measurement(ControlBoardsInterface::current_0);
-    case knee_joint:
-      return board_->get_measurement(ControlBoardsInterface::current_1);
-    default:
-      break;
-    }
+    : Encoder(board, motor_id), board_(board), motor_id_(motor_id) {
+  // The motors also measure their current.
+  switch (motor_id_) {
+  case hip_joint:
+    set_measurement_channel(current, ControlBoardsInterface::current_0);
+    break;
+  case knee_joint:
+    set_measurement_channel(current, ControlBoardsInterface::current_1);
+    break;
+  default:
+    break;
   }
-  return Encoder::get_measurement(index);
 }
 
 Ptr<const Motor::StatusTimeseries> Motor::get_status() const {
@@ -62,23 +59,25 @@ void Motor::print() const {
     motor_board_status = get_status()->newest_element();
   }
 
-  if (get_measurement(current)->length() != 0) {
+  if (get_measurement(current) && get_measurement(current)->length() != 0) {
     motor_current = get_measurement(current)->newest_element();
   }
 
-  if (get_measurement(position)->length() != 0) {
+  if (get_measurement(position) && get_measurement(position)->length() != 0) {
     motor_position = get_measurement(position)->newest_element();
   }
 
-  if (get_measurement(velocity)->length() != 0) {
+  if (get_measurement(velocity) && get_measurement(velocity)->length() != 0) {
     motor_velocity = get_measurement(velocity)->newest_element();
   }
 
-  if (get_measurement(acceleration)->length() != 0) {
+  if (get_measurement(acceleration) &&
+      get_measurement(acceleration)->length() != 0) {
     motor_acceleration = get_measurement(acceleration)->newest_element();
   }
 
-  if (get_measurement(encoder_index)->length() != 0) {
+  if (get_measurement(encoder_index) &&
+      get_measurement(encoder_index)->length() != 0) {
     motor_encoder_index = get_measurement(encoder_index)->newest_element();
   }
 
@@ -65,6 +65,13 @@ double MotorJointModule::get_measured_torque() const {
       get_joint_measurement(Measurements::current));
 }
 
+double
+MotorJointModule::get_measured_torque(const BoardsSnapshot &snapshot) const {
+  return motor_current_to_joint_torque(
+      polarity_ * snapshot.measurements[motor_->get_measurement_index(
+                      Measurements::current)]);
+}
+
 double MotorJointModule::joint_torque_to_motor_current(double torque) const {
   return torque / gear_ratio_ / motor_constant_;
 }
@@ -89,6 +96,18 @@ double MotorJointModule::execute_position_controller(
   return desired_torque;
 }
 
+double MotorJointModule::execute_position_controller(
+    const double &target_position_rad,
+    const double &target_velocity_rad_per_sec,
+    const double &measured_position_rad,
+    const double &measured_velocity_rad_per_sec) const {
+  // PD control tracking the reference velocity.
+  return position_control_gain_p_ *
+             (target_position_rad - measured_position_rad) +
+         position_control_gain_d_ *
+             (target_velocity_rad_per_sec - measured_velocity_rad_per_sec);
+}
+
 void MotorJointModule::homing_at_current_position(double home_offset_rad) {
   // reset the internal zero angle.
   set_zero_angle(0.0);
@@ -119,12 +138,17 @@ void MotorJointModule::init_homing(double search_distance_limit_rad,
   rt_printf("target pos init... %.3f \n", homing_state_.target_position_rad);
 
   homing_state_.step_count = 0;
-  homing_state_.start_position = get_measured_angle();
+  homing_state_.start_position = homing_state_.target_position_rad;
 
   homing_state_.status = HomingReturnCode::RUNNING;
 }
 
 HomingReturnCode MotorJointModule::update_homing() {
+  return update_homing(homing_state_.profile_step_size_rad);
+}
+
+HomingReturnCode
+MotorJointModule::update_homing(const double &profile_step_size_rad) {
   switch (homing_state_.status) {
   case HomingReturnCode::NOT_INITIALIZED:
     set_torque(0.0);
@@ -148,13 +172,11 @@ HomingReturnCode MotorJointModule::update_homing() {
   }
 
   case HomingReturnCode::RUNNING: {
-    // number of steps after which the distance limit is reached
-    const uint32_t max_step_count =
-        std::abs(homing_state_.search_distance_limit_rad /
-                 homing_state_.profile_step_size_rad);
-
-    // abort if distance limit is reached
-    if (homing_state_.step_count >= max_step_count) {
+    // abort if distance limit is reached, the step size may vary from one
+    // step to the next.
+    if (std::abs(homing_state_.target_position_rad -
+                 homing_state_.start_position) >=
+        std::abs(homing_state_.search_distance_limit_rad)) {
       set_torque(0.0);
       homing_state_.status = HomingReturnCode::FAILED;
 
@@ -167,7 +189,7 @@ HomingReturnCode MotorJointModule::update_homing() {
     // -- EXECUTE ONE STEP
 
     homing_state_.step_count++;
-    homing_state_.target_position_rad += homing_state_.profile_step_size_rad;
+    homing_state_.target_position_rad += profile_step_size_rad;
 
 #ifdef VERBOSE
     const double current_position = get_measured_angle();
@@ -0,0 +1,123 @@
+#include "monopod_sdk/shared_memory_bridge.hpp"
+
+namespace monopod_drivers {
+
+SharedMemoryBridge::SharedMemoryBridge(Ptr<Monopod> monopod,
+                                       const std::string &segment_id,
+                                       const size_t &history_length,
+                                       const double &period_s)
+    : monopod_(monopod), segment_id_(segment_id), period_s_(period_s) {
+  // Remove the segments left by a bridge which did not exit cleanly.
+  time_series::clear_memory(state_segment(segment_id_));
+  time_series::clear_memory(command_segment(segment_id_));
+
+  states_ = SharedStateTimeseries::create_leader_ptr(
+      state_segment(segment_id_), history_length);
+  commands_ = SharedCommandTimeseries::create_leader_ptr(
+      command_segment(segment_id_), history_length);
+
+  // The bridge only serves other processes, it must never preempt the
+  // threads talking to the boards, see RealtimeConfig::bridge.
+  monopod_->get_realtime_config().bridge.apply(thread_);
+  is_loop_active_ = true;
+  thread_.create_realtime_thread(&SharedMemoryBridge::loop, this);
+}
+
+SharedMemoryBridge::~SharedMemoryBridge() {
+  is_loop_active_ = false;
+  thread_.join();
+  states_.reset();
+  commands_.reset();
+  time_series::clear_memory(state_segment(segment_id_));
+  time_series::clear_memory(command_segment(segment_id_));
+}
+
+void SharedMemoryBridge::loop() {
+  real_time_tools::Spinner spinner;
+  spinner.set_period(period_s_);
+
+  StateSnapshot state;
+  uint64_t published_frame_count = 0;
+  Index applied_timeindex = -1;
+
+  Vector<double> torque_targets;
+  Vector<int> joint_indexes;
+  torque_targets.reserve(NUMBER_JOINTS);
+  joint_indexes.reserve(NUMBER_JOINTS);
+
+  while (is_loop_active_) {
+    // publish the state if the boards sent new measurements -------------
+    monopod_->read_state(state);
+    if (state.frame_count != published_frame_count) {
+      states_->append(state);
+      published_frame_count = state.frame_count;
+    }
+
+    // apply the newest command, older ones are outdated ------------------
+    if (commands_->length() > 0 &&
+        commands_->newest_timeindex(false) > applied_timeindex) {
+      applied_timeindex = commands_->newest_timeindex(false);
+      TorqueCommand command = (*commands_)[applied_timeindex];
+
+      torque_targets.clear();
+      joint_indexes.clear();
+      for (int joint = 0; joint < NUMBER_JOINTS; joint++) {
+        if ((command.joints >> joint) & 1u) {
+          torque_targets.push_back(command.torque[joint]);
+          joint_indexes.push_back(joint);
+        }
+      }
+      // The monopod may be holding or calibrating meanwhile, the command is
+      // then dropped.
+      if (!joint_indexes.empty() && monopod_->valid()) {
+        monopod_->try_set_torque_targets(torque_targets, joint_indexes);
+      }
+    }
+
+    spinner.spin();
+  }
+}
+
+SharedMemoryClient::SharedMemoryClient(const std::string &segment_id) {
+  states_ = SharedStateTimeseries::create_follower_ptr(
+      SharedMemoryBridge::state_segment(segment_id));
+  commands_ = SharedCommandTimeseries::create_follower_ptr(
+      SharedMemoryBridge::command_segment(segment_id));
+  state_timeindex_ =
+      states_->length() == 0 ? -1 : states_->newest_timeindex(false);
+}
+
+bool SharedMemoryClient::read_state(StateSnapshot &state) const {
+  if (states_->length() == 0) {
+    return false;
+  }
+  state = states_->newest_element();
+  return true;
+}
+
+bool SharedMemoryClient::wait_for_new_state(const double &timeout_s) {
+  if (!states_->wait_for_timeindex(state_timeindex_ + 1, timeout_s)) {
+    return false;
+  }
+  state_timeindex_ = states_->newest_timeindex(false);
+  return true;
+}
+
+void SharedMemoryClient::set_torque_targets(
+    const Vector<double> &torque_targets, const Vector<int> &joint_indexes) {
+  if (torque_targets.size() != joint_indexes.size()) {
+    throw std::invalid_argument(
+        "There must be one torque target per joint index.");
+  }
+  TorqueCommand command;
+  for (size_t i = 0; i < joint_indexes.size(); i++) {
+    if (joint_indexes[i] < 0 || joint_indexes[i] >= NUMBER_JOINTS) {
+      throw std::invalid_argument("The joint indexes must be JointNamesIndex.");
+    }
+    command.torque[joint_indexes[i]] = torque_targets[i];
+    command.joints |= 1u << joint_indexes[i];
+  }
+  commands_->append(command);
+}
+
+} // namespace monopod_drivers
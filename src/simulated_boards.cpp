@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cmath>
+
+#include "monopod_sdk/monopod_drivers/devices/simulated_boards.hpp"
+#include "real_time_tools/spinner.hpp"
+
+namespace monopod_drivers {
+
+SimulatedControlBoards::SimulatedControlBoards(
+    const SimulationParameters &parameters, const HistoryConfig &history,
+    const ThreadPolicy &thread)
+    : parameters_(parameters), step_count_(0), is_safemode_(false),
+      is_loop_active_(false) {
+  if (!(parameters_.time_step > 0.0)) {
+    throw std::invalid_argument("the time step must be positive.");
+  }
+  history.validate();
+  thread.apply(rt_thread_);
+  position_.fill(0.0);
+  velocity_.fill(0.0);
+  acceleration_.fill(0.0);
+  current_.fill(0.0);
+
+  measurement_ = create_vector_of_pointers<ScalarTimeseries>(
+      measurement_count, history.measurement_length);
+
+  status_ = create_vector_of_pointers<StatusTimeseries>(
+      board_count, history.status_length);
+
+  control_ = create_vector_of_pointers<ScalarTimeseries>(
+      control_count, history.control_length);
+
+  command_ =
+      std::make_shared<CommandTimeseries>(history.control_length, 0, false);
+
+  sent_control_ = create_vector_of_pointers<ScalarTimeseries>(
+      control_count, history.sent_length);
+
+  sent_command_ =
+      std::make_shared<CommandTimeseries>(history.sent_length, 0, false);
+
+  BoardStatus status;
+  status.system_enabled = 1;
+  status.motor1_enabled = 1;
+  status.motor1_ready = 1;
+  status.motor2_enabled = 1;
+  status.motor2_ready = 1;
+  status.error_code = 0;
+  for (size_t i = 0; i < status_.size(); i++) {
+    status_[i]->append(status);
+    decoded_.status[i] = status;
+  }
+
+  for (size_t i = 0; i < control_.size(); i++) {
+    control_[i]->append(0.0);
+    sent_control_[i]->append(0.0);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(model_door_);
+    publish();
+  }
+
+  if (parameters_.real_time) {
+    is_loop_active_ = true;
+    rt_thread_.create_realtime_thread(&SimulatedControlBoards::loop, this);
+  }
+}
+
+SimulatedControlBoards::~SimulatedControlBoards() {
+  if (is_loop_active_) {
+    is_loop_active_ = false;
+    rt_thread_.join();
+  }
+}
+
+double SimulatedControlBoards::get_time() const {
+  std::lock_guard<std::mutex> lock(model_door_);
+  return step_count_ * parameters_.time_step;
+}
+
+BoardsStats SimulatedControlBoards::get_stats() const {
+  BoardsStats stats;
+  std::lock_guard<std::mutex> lock(model_door_);
+  stats.decoded_frames = step_count_;
+  return stats;
+}
+
+void SimulatedControlBoards::set_recorder(Ptr<TelemetryRecorder> recorder) {
+  std::lock_guard<std::mutex> lock(model_door_);
+  recorder_ = recorder;
+}
+
+void SimulatedControlBoards::send_if_input_changed() {
+  if (command_->has_changed_since_tag()) {
+    // The simulated motors are always enabled, the commands are only kept
+    // for the record.
+    command_->tag(command_->newest_timeindex());
+    sent_command_->append(command_->newest_element());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(model_door_);
+    for (size_t i = 0; i < control_.size(); i++) {
+      Index timeindex = control_[i]->newest_timeindex();
+      control_[i]->tag(timeindex);
+      double control = is_safemode_ ? 0.0 : (*control_[i])[timeindex];
+      sent_control_[i]->append(control);
+      current_[i] = std::max(-MAX_CURRENT, std::min(control, MAX_CURRENT));
+    }
+  }
+
+  if (!parameters_.real_time) {
+    step();
+  }
+}
+
+void SimulatedControlBoards::step(const size_t &step_count) {
+  std::lock_guard<std::mutex> lock(model_door_);
+  for (size_t i = 0; i < step_count; i++) {
+    integrate();
+    publish();
+  }
+}
+
+void SimulatedControlBoards::set_joint_state(const int &joint_index,
+                                             const double &position,
+                                             const double &velocity) {
+  const int model_index = get_model_index(joint_index);
+  std::lock_guard<std::mutex> lock(model_door_);
+  position_[model_index] = position;
+  velocity_[model_index] = velocity;
+  acceleration_[model_index] = 0.0;
+  publish();
+}
+
+void SimulatedControlBoards::loop() {
+  real_time_tools::Spinner spinner;
+  spinner.set_period(parameters_.time_step);
+  while (is_loop_active_) {
+    step();
+    spinner.spin();
+  }
+}
+
+void SimulatedControlBoards::integrate() {
+  static const double no_current = 0.0;
+  SimulationStateView state;
+  for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+    state.position[i] = &position_[i];
+    state.velocity[i] = &velocity_[i];
+    state.acceleration[i] = &acceleration_[i];
+  }
+  state.current[0] = is_safemode_ ? &no_current : &current_[current_target_0];
+  state.current[1] = is_safemode_ ? &no_current : &current_[current_target_1];
+  integrate_model(parameters_, state, 0, 1);
+  step_count_++;
+}
+
+void SimulatedControlBoards::integrate_model(
+    const SimulationParameters &parameters, const SimulationStateView &state,
+    const size_t &begin, const size_t &end) {
+  const SimulationParameters &p = parameters;
+  const int hip = get_model_index(hip_joint);
+  const int knee = get_model_index(knee_joint);
+  const int pitch = get_model_index(planarizer_pitch_joint);
+
+  for (size_t robot = begin; robot < end; robot++) {
+    std::array<double, NUMBER_JOINTS> torque;
+    torque.fill(0.0);
+    torque[hip] = state.current[0][robot] * p.motor_constant * p.gear_ratio;
+    torque[knee] = state.current[1][robot] * p.motor_constant * p.gear_ratio;
+    // The hip motor is mounted on the planarizer which takes its reaction.
+    torque[pitch] = -torque[hip];
+
+    // The leg hangs from the planarizer like a double pendulum.
+    const double hip_angle = state.position[hip][robot];
+    const double shank_angle = hip_angle + state.position[knee][robot];
+    const double shank_gravity = p.shank_mass * p.gravity * 0.5 *
+                                 p.shank_length * std::sin(shank_angle);
+    const double thigh_gravity = (0.5 * p.thigh_mass + p.shank_mass) *
+                                 p.gravity * p.thigh_length *
+                                 std::sin(hip_angle);
+    torque[hip] -= thigh_gravity + shank_gravity;
+    torque[knee] -= shank_gravity;
+
+    // semi implicit Euler.
+    for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+      double &velocity = state.velocity[i][robot];
+      const double acceleration =
+          (torque[i] - p.damping[i] * velocity) / p.inertia[i];
+      state.acceleration[i][robot] = acceleration;
+      velocity += acceleration * p.time_step;
+      state.position[i][robot] += velocity * p.time_step;
+    }
+  }
+}
+
+void SimulatedControlBoards::publish() {
+  const uint64_t timestamp_ns = step_count_ * parameters_.time_step * 1e9;
+  auto decode = [this, &timestamp_ns](const int &index, const double &value) {
+    decoded_.measurements[index] = value;
+    if (recorder_) {
+      recorder_->record_measurement(index, value, timestamp_ns);
+    }
+  };
+
+  // The leg encoders are on the motor side of the gears.
+  for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+    const double ratio = i < NUMBER_LEG_JOINTS ? parameters_.gear_ratio : 1.0;
+    decode(position_0 + i, ratio * position_[i]);
+    decode(velocity_0 + i, ratio * velocity_[i]);
+    decode(acceleration_0 + i, ratio * acceleration_[i]);
+  }
+  decode(current_0, current_[current_target_0]);
+  decode(current_1, current_[current_target_1]);
+
+  decoded_.frame_count = step_count_;
+  decoded_.publish_time_ns = get_wall_time_ns();
+  snapshot_.store(decoded_);
+
+  // Appending wakes up the threads waiting on the time series, the snapshot
+  // they read is published first.
+  for (size_t i = 0; i < NUMBER_JOINTS; i++) {
+    measurement_[position_0 + i]->append(decoded_.measurements[position_0 + i]);
+    measurement_[velocity_0 + i]->append(decoded_.measurements[velocity_0 + i]);
+    measurement_[acceleration_0 + i]->append(
+        decoded_.measurements[acceleration_0 + i]);
+  }
+  measurement_[current_0]->append(decoded_.measurements[current_0]);
+  measurement_[current_1]->append(decoded_.measurements[current_1]);
+}
+
+int SimulatedControlBoards::get_model_index(const int &joint_index) {
+  switch (joint_index) {
+  case hip_joint:
+    return position_0 - position_0;
+  case knee_joint:
+    return position_1 - position_0;
+  case planarizer_pitch_joint:
+    return position_2 - position_0;
+  case planarizer_yaw_joint:
+    return position_3 - position_0;
+  case boom_connector_joint:
+    return position_4 - position_0;
+  default:
+    throw std::invalid_argument("unknown joint index.");
+  }
+}
+
+} // namespace monopod_drivers
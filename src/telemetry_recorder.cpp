@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstring>
+
+#include "monopod_sdk/monopod_drivers/devices/telemetry_recorder.hpp"
+#include "real_time_tools/timer.hpp"
+
+namespace monopod_drivers {
+
+/**
+ * @brief Get the steady clock time in nano seconds.
+ */
+static uint64_t get_host_time_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+TelemetryRecorder::TelemetryRecorder(const size_t &capacity,
+                                     const ThreadPolicy &thread)
+    : records_(capacity), file_(nullptr), is_recording_(false),
+      is_loop_active_(false), dropped_records_(0), thread_policy_(thread) {
+  thread_policy_.apply(thread_);
+}
+
+TelemetryRecorder::~TelemetryRecorder() { stop(); }
+
+bool TelemetryRecorder::start(const std::string &file_name) {
+  if (is_loop_active_) {
+    rt_printf("TelemetryRecorder::start(): already recording.\n");
+    return false;
+  }
+
+  file_ = fopen(file_name.c_str(), "wb");
+  if (file_ == nullptr) {
+    rt_printf("TelemetryRecorder::start(): could not open %s.\n",
+              file_name.c_str());
+    return false;
+  }
+  TelemetryFileHeader header;
+  fwrite(&header, sizeof(header), 1, file_);
+
+  // discard what was pushed while not recording.
+  TelemetryRecord record;
+  while (records_.try_pop(record)) {
+  }
+
+  dropped_records_ = 0;
+  is_loop_active_ = true;
+  thread_.parameters_.block_memory_ = false;
+  thread_.create_realtime_thread(&TelemetryRecorder::loop, this);
+  is_recording_ = true;
+  return true;
+}
+
+void TelemetryRecorder::stop() {
+  if (!is_loop_active_) {
+    return;
+  }
+  is_recording_ = false;
+  is_loop_active_ = false;
+  thread_.join();
+
+  flush();
+  fclose(file_);
+  file_ = nullptr;
+
+  if (dropped_records_ > 0) {
+    rt_printf("TelemetryRecorder::stop(): %lu records were dropped.\n",
+              (unsigned long)dropped_records_.load());
+  }
+}
+
+void TelemetryRecorder::record_frame(const TelemetryRecord::Kind &kind,
+                                     const size_t &bus,
+                                     const CanBusFrame &frame) {
+  if (!is_recording()) {
+    return;
+  }
+  TelemetryRecord record;
+  record.host_time_ns = get_host_time_ns();
+  record.timestamp_ns = frame.timestamp;
+  record.can_id = frame.id;
+  record.channel = bus;
+  record.kind = kind;
+  record.dlc = frame.dlc;
+  memcpy(record.data, frame.data.data(), sizeof(record.data));
+  push(record);
+}
+
+void TelemetryRecorder::record_measurement(const int &index,
+                                           const double &value,
+                                           const uint64_t &timestamp_ns) {
+  if (!is_recording()) {
+    return;
+  }
+  TelemetryRecord record;
+  record.host_time_ns = get_host_time_ns();
+  record.timestamp_ns = timestamp_ns;
+  record.can_id = 0;
+  record.channel = index;
+  record.kind = TelemetryRecord::MEASUREMENT;
+  record.dlc = sizeof(value);
+  memcpy(record.data, &value, sizeof(value));
+  push(record);
+}
+
+void TelemetryRecorder::push(TelemetryRecord &record) {
+  if (!records_.try_push(record)) {
+    dropped_records_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void TelemetryRecorder::loop() {
+  while (is_loop_active_) {
+    if (flush() == 0) {
+      real_time_tools::Timer::sleep_ms(1.0);
+    }
+  }
+}
+
+size_t TelemetryRecorder::flush() {
+  TelemetryRecord batch[256];
+  size_t written = 0;
+  size_t count = 0;
+  do {
+    count = 0;
+    while (count < 256 && records_.try_pop(batch[count])) {
+      count++;
+    }
+    fwrite(batch, sizeof(TelemetryRecord), count, file_);
+    written += count;
+  } while (count == 256);
+  return written;
+}
+
+} // namespace monopod_drivers
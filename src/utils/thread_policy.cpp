@@ -0,0 +1,92 @@
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "monopod_sdk/monopod_drivers/utils/os_interface.hpp"
+#include "monopod_sdk/monopod_drivers/utils/thread_policy.hpp"
+
+namespace monopod_drivers {
+
+void ThreadPolicy::apply(real_time_tools::RealTimeThread &thread) const {
+  if (priority == 0 || priority > 99) {
+    throw std::invalid_argument(
+        "the priority of a thread must be between 1 and 99.");
+  }
+  if (cpu >= 0) {
+    thread.parameters_.cpu_id_ = {cpu};
+  }
+  if (priority >= 0) {
+    thread.parameters_.priority_ = priority;
+  }
+  if (stack_size > 0) {
+    thread.parameters_.stack_size_ = stack_size;
+  }
+}
+
+/**
+ * @brief Touch every page of a stack buffer, kept out of line such that the
+ * buffer really lives on the stack of the caller.
+ *
+ * @param bytes
+ */
+static void __attribute__((noinline)) prefault_stack(const size_t &bytes) {
+  volatile unsigned char *stack =
+      static_cast<volatile unsigned char *>(alloca(bytes));
+  const long page_size = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < bytes; i += page_size) {
+    stack[i] = 0;
+  }
+}
+
+/**
+ * @brief Number of bytes of stack the real-time threads fault in, see
+ * MemoryPolicy::prefault_thread_stack.
+ */
+static std::atomic<size_t> thread_stack_prefault_bytes(0);
+
+void MemoryPolicy::prefault_thread_stack() {
+  const size_t bytes = thread_stack_prefault_bytes.load();
+  if (bytes > 0) {
+    prefault_stack(bytes);
+  }
+}
+
+bool MemoryPolicy::apply() const {
+  bool success = true;
+  if (lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    rt_printf("WARNING: the memory of the process could not be locked (%s).\n",
+              strerror(errno));
+    success = false;
+  }
+
+  if (heap_prefault_bytes > 0) {
+    // Keep the freed memory in the heap instead of giving it back.
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    unsigned char *heap =
+        static_cast<unsigned char *>(malloc(heap_prefault_bytes));
+    if (heap == nullptr) {
+      rt_printf("WARNING: the heap could not be prefaulted.\n");
+      success = false;
+    } else {
+      volatile unsigned char *pages = heap;
+      const long page_size = sysconf(_SC_PAGESIZE);
+      for (size_t i = 0; i < heap_prefault_bytes; i += page_size) {
+        pages[i] = 0;
+      }
+      free(heap);
+    }
+  }
+
+  thread_stack_prefault_bytes = stack_prefault_bytes;
+  prefault_thread_stack();
+  return success;
+}
+
+} // namespace monopod_drivers
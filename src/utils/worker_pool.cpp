@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "monopod_sdk/monopod_drivers/utils/worker_pool.hpp"
+
+namespace monopod_drivers {
+
+WorkerPool::WorkerPool(const size_t &worker_count)
+    : job_(nullptr), task_count_(0), generation_(0), pending_workers_(0),
+      is_stopping_(false) {
+  size_t count = worker_count;
+  if (count == 0) {
+    count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t worker = 1; worker < count; worker++) {
+    threads_.emplace_back(&WorkerPool::work, this, worker);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(door_);
+    is_stopping_ = true;
+  }
+  job_condition_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::run(const size_t &task_count, const Job &job) {
+  if (task_count == 0) {
+    return;
+  }
+  if (threads_.empty()) {
+    job(0, task_count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(door_);
+    job_ = &job;
+    task_count_ = task_count;
+    pending_workers_ = threads_.size();
+    generation_++;
+  }
+  job_condition_.notify_all();
+
+  run_block(0);
+
+  std::unique_lock<std::mutex> lock(door_);
+  done_condition_.wait(lock, [this] { return pending_workers_ == 0; });
+  job_ = nullptr;
+}
+
+void WorkerPool::run_block(const size_t &worker) {
+  const size_t worker_count = get_worker_count();
+  const size_t begin = task_count_ * worker / worker_count;
+  const size_t end = task_count_ * (worker + 1) / worker_count;
+  if (begin < end) {
+    (*job_)(begin, end);
+  }
+}
+
+void WorkerPool::work(const size_t &worker) {
+  uint64_t generation = 0;
+  std::unique_lock<std::mutex> lock(door_);
+  while (true) {
+    job_condition_.wait(lock, [this, &generation] {
+      return is_stopping_ || generation_ != generation;
+    });
+    if (is_stopping_) {
+      return;
+    }
+    generation = generation_;
+
+    lock.unlock();
+    run_block(worker);
+    lock.lock();
+
+    if (--pending_workers_ == 0) {
+      done_condition_.notify_one();
+    }
+  }
+}
+
+} // namespace monopod_drivers